@@ -10,10 +10,15 @@ import serial
 ser = serial.Serial('/dev/ttyS10', 115200, timeout=0.050)
 count = 0
 
+# The data files are stored with LF line ends. Real meters send CRLF
+# and the telegram CRC is calculated over CRLF line ends.
+def p1data(path):
+  return open(path,"rb").read().replace(b'\r\n', b'\n').replace(b'\n', b'\r\n')
+
 while 1:
   #ser.write(b'Sent %d time(s)\r\n')
-  ser.write(open("hanp1_1.data","rb").read())
+  ser.write(p1data("hanp1_1.data"))
   time.sleep(1)
-  ser.write(open("hanp1_2.data","rb").read())
+  ser.write(p1data("hanp1_2.data"))
   time.sleep(1)
   count += 1
\ No newline at end of file
@@ -26,7 +26,11 @@
 // SOFTWARE.
 //
 
+#include <string.h>
+
 #include <vscp.h>
+#include <vscp_class.h>
+#include <vscp_type.h>
 
 #include "alarm.h"
 
@@ -36,9 +40,16 @@
 
 CAlarm::CAlarm()
 {
-  m_name    = "";
-  m_zone    = 0;
-  m_subzone = 0;
+  m_name      = "";
+  m_bSent     = false;
+  m_op        = alarm_op::gt;
+  m_value     = 0;
+  m_bOneShot  = false;
+  m_alarmByte = 0;
+  m_zone      = 0;
+  m_subzone   = 0;
+  m_bReset    = false;
+  memset(&m_ex, 0, sizeof(m_ex));
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -53,6 +64,8 @@ CAlarm::CAlarm(const std::string name,
                uint8_t subzone,
                bool bOneShoot)
 {
+  m_bReset = false;
+  memset(&m_ex, 0, sizeof(m_ex));
   init(name, op, value, b, zone, subzone, bOneShoot);
 }
 
@@ -91,8 +104,10 @@ CAlarm::init(const std::string name,
     return false;
   }
 
-  m_name = name;
-  m_op   = op;
+  m_name     = name;
+  m_op       = op;
+  m_value    = value;
+  m_bOneShot = bOneShoot;
 
   m_alarmByte = b;
   m_zone      = zone;
@@ -114,5 +129,86 @@ CAlarm::setOperation(const std::string &strop)
   else if ("<" == strop) {
     m_op = alarm_op::lt;
   }
+  else if (">=" == strop) {
+    m_op = alarm_op::ge;
+  }
+  else if ("<=" == strop) {
+    m_op = alarm_op::le;
+  }
+  else if ("==" == strop) {
+    m_op = alarm_op::eq;
+  }
+  else if ("!=" == strop) {
+    m_op = alarm_op::ne;
+  }
+  else {
+    return false;
+  }
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// buildEvent
+//
+
+void
+CAlarm::buildEvent(const uint8_t *pguid, uint8_t guidLsb)
+{
+  memset(&m_ex, 0, sizeof(m_ex));
+  m_ex.head       = VSCP_HEADER16_GUID_TYPE_STANDARD | VSCP_PRIORITY_NORMAL | VSCP_HEADER16_DUMB;
+  m_ex.vscp_class = VSCP_CLASS1_ALARM;
+  m_ex.vscp_type  = m_bReset ? VSCP_TYPE_ALARM_RESET : VSCP_TYPE_ALARM_ALARM;
+  memcpy(m_ex.GUID, pguid, 16);
+  m_ex.GUID[15] = guidLsb;
+  m_ex.sizeData = 3;
+  m_ex.data[0]  = m_alarmByte;
+  m_ex.data[1]  = m_zone;
+  m_ex.data[2]  = m_subzone;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// check
+//
+
+bool
+CAlarm::check(double value)
+{
+  bool bCondition;
+
+  switch (m_op) {
+    case alarm_op::gt:
+      bCondition = (value > m_value);
+      break;
+    case alarm_op::lt:
+      bCondition = (value < m_value);
+      break;
+    case alarm_op::ge:
+      bCondition = (value >= m_value);
+      break;
+    case alarm_op::le:
+      bCondition = (value <= m_value);
+      break;
+    case alarm_op::eq:
+      bCondition = (value == m_value);
+      break;
+    case alarm_op::ne:
+      bCondition = (value != m_value);
+      break;
+    default:
+      bCondition = false;
+      break;
+  }
+
+  // Armed again when the condition is no longer true
+  if (!bCondition) {
+    m_bSent = false;
+    return false;
+  }
+
+  if (m_bSent && m_bOneShot) {
+    return false;
+  }
+
+  m_bSent = true;
   return true;
 }
\ No newline at end of file
@@ -37,7 +37,9 @@
 #include <sstream>
 #include <string>
 
-enum class alarm_op { gt, lt };
+#include <vscp.h>
+
+enum class alarm_op { gt, lt, ge, le, eq, ne };
 
 class CAlarm {
 
@@ -57,7 +59,7 @@ public:
   ~CAlarm();
 
   /*!
-    Set up P1 item
+    Set up alarm
     @param name Variable name to check
     @param op Compare operation
     @param value Value to compare named variable with.
@@ -78,7 +80,7 @@ public:
   /*
     Name = "variable" in config
   */
-  std::string getVariable(void) { return m_name; };
+  const std::string &getVariable(void) const { return m_name; };
   void setVariable(const std::string &name) { m_name = name; };
 
   /*!
@@ -97,8 +99,12 @@ public:
     Set operation from string
     @param strop Operation in string format
             "<" - Less than
-            ">" - Greate than
-    @return true on success        
+            ">" - Greater than
+            "<=" - Less than or equal
+            ">=" - Greater than or equal
+            "==" - Equal
+            "!=" - Not equal
+    @return true on success, false for an unknown operation
   */
   bool setOperation(const std::string& strop);
 
@@ -132,6 +138,34 @@ public:
   bool isOneShot(void) { return m_bOneShot; };
   void setOneShot(bool bOneShot = true) { m_bOneShot = bOneShot; };
 
+  /*
+    Reset. True for an "off" alarm that sends an alarm reset event,
+    false for an "on" alarm that sends an alarm event.
+  */
+  bool isReset(void) const { return m_bReset; };
+  void setReset(bool bReset = true) { m_bReset = bReset; };
+
+  /*!
+    Build the alarm event once so sending it is a copy
+    @param pguid GUID of the driver
+    @param guidLsb Least significant byte of GUID (from the item)
+  */
+  void buildEvent(const uint8_t *pguid, uint8_t guidLsb);
+
+  /*!
+    Prebuilt alarm event. Only date/time need to be set.
+  */
+  const vscpEventEx &getEventEx(void) const { return m_ex; };
+
+  /*!
+    Check a new value for the variable
+    @param value Value to check
+    @return true if the alarm event should be sent. A one-shot
+            alarm is sent once when the condition becomes true and
+            again only after the condition has been false.
+  */
+  bool check(double value);
+
 private:
   /*!
     Name on variable to test
@@ -173,6 +207,16 @@ private:
     Subzone to use for event
   */
   uint8_t m_subzone;
+
+  /*!
+    True if alarm reset should be sent instead of alarm
+  */
+  bool m_bReset;
+
+  /*!
+    Alarm event built when the configuration is loaded
+  */
+  vscpEventEx m_ex;
 };
 
 #endif // VSCP_ALARM_H__INCLUDED_
\ No newline at end of file
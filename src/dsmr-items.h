@@ -0,0 +1,172 @@
+// dsmr-items.h
+//
+// This file is part of the VSCP (https://www.vscp.org)
+//
+// The MIT License (MIT)
+//
+// Copyright © 2000-2024 Ake Hedman, the VSCP Project
+// <akhe@vscp.org>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#if !defined(VSCP_DSMR_ITEMS_H__INCLUDED_)
+#define VSCP_DSMR_ITEMS_H__INCLUDED_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "obis.h"
+#include "p1line.h"
+
+/*!
+  Default definition of one P1 item
+*/
+struct dsmr_item {
+  const char *token;       // OBIS code
+  const char *description; // Description
+  uint16_t vscpClass;      // VSCP class for events
+  uint16_t vscpType;       // VSCP type for events
+  uint8_t sensorIndex;     // Sensor index (also used as GUID lsb)
+  double factor;           // Factor applied to value
+  const char *unit;        // Unit as sent by the meter
+  uint8_t vscpUnit;        // VSCP unit code for unit
+  const char *store;       // Storage name for last value
+  int valueGroup;          // (...) group holding the value
+  int timeGroup;           // (...) group holding a time stamp
+};
+
+/*!
+  Standard DSMR 5.0.2 / HAN OBIS codes.
+
+  Used as item list when the configuration file has no "items" array
+  (or "builtin-items" is set). Items in the configuration with the
+  same token override fields of the built in item.
+
+  All items send VSCP_CLASS2_MEASUREMENT_STR (1040) events. Power is
+  sent in W and reactive power/energy in var/varh (factor 1000 from
+  the kW/kvar/kvarh the meter reports), energy in kWh.
+*/
+static constexpr dsmr_item dsmr_items[] = {
+  // Energy registers (type 13 = energy, 65 = reactive energy)
+  { "1-0:1.8.0", "Energy out", 1040, 13, 0, 1, "kWh", 1, "energy_out", 0, P1_LINE_NO_GROUP },
+  { "1-0:2.8.0", "Energy in", 1040, 13, 1, 1, "kWh", 1, "energy_in", 0, P1_LINE_NO_GROUP },
+  { "1-0:3.8.0", "Reactive energy out", 1040, 65, 2, 1000, "kvarh", 0, "reactive_energy_out", 0, P1_LINE_NO_GROUP },
+  { "1-0:4.8.0", "Reactive energy in", 1040, 65, 3, 1000, "kvarh", 0, "reactive_energy_in", 0, P1_LINE_NO_GROUP },
+
+  // Instantaneous power (type 14 = power, 64 = reactive power)
+  { "1-0:1.7.0", "Active effect out", 1040, 14, 4, 1000, "kW", 0, "active_effect_out", 0, P1_LINE_NO_GROUP },
+  { "1-0:2.7.0", "Active effect in", 1040, 14, 5, 1000, "kW", 0, "active_effect_in", 0, P1_LINE_NO_GROUP },
+  { "1-0:3.7.0", "Reactive effect out", 1040, 64, 6, 1000, "kvar", 0, "reactive_effect_out", 0, P1_LINE_NO_GROUP },
+  { "1-0:4.7.0", "Reactive effect in", 1040, 64, 7, 1000, "kvar", 0, "reactive_effect_in", 0, P1_LINE_NO_GROUP },
+
+  // Instantaneous power per phase
+  { "1-0:21.7.0", "Active effect out L1", 1040, 14, 8, 1000, "kW", 0, "active_effect_out_l1", 0, P1_LINE_NO_GROUP },
+  { "1-0:41.7.0", "Active effect out L2", 1040, 14, 9, 1000, "kW", 0, "active_effect_out_l2", 0, P1_LINE_NO_GROUP },
+  { "1-0:61.7.0", "Active effect out L3", 1040, 14, 10, 1000, "kW", 0, "active_effect_out_l3", 0, P1_LINE_NO_GROUP },
+  { "1-0:22.7.0", "Active effect in L1", 1040, 14, 11, 1000, "kW", 0, "active_effect_in_l1", 0, P1_LINE_NO_GROUP },
+  { "1-0:42.7.0", "Active effect in L2", 1040, 14, 12, 1000, "kW", 0, "active_effect_in_l2", 0, P1_LINE_NO_GROUP },
+  { "1-0:62.7.0", "Active effect in L3", 1040, 14, 13, 1000, "kW", 0, "active_effect_in_l3", 0, P1_LINE_NO_GROUP },
+  { "1-0:23.7.0", "Reactive effect out L1", 1040, 64, 14, 1000, "kvar", 0, "reactive_effect_out_l1", 0, P1_LINE_NO_GROUP },
+  { "1-0:43.7.0", "Reactive effect out L2", 1040, 64, 15, 1000, "kvar", 0, "reactive_effect_out_l2", 0, P1_LINE_NO_GROUP },
+  { "1-0:63.7.0", "Reactive effect out L3", 1040, 64, 16, 1000, "kvar", 0, "reactive_effect_out_l3", 0, P1_LINE_NO_GROUP },
+  { "1-0:24.7.0", "Reactive effect in L1", 1040, 64, 17, 1000, "kvar", 0, "reactive_effect_in_l1", 0, P1_LINE_NO_GROUP },
+  { "1-0:44.7.0", "Reactive effect in L2", 1040, 64, 18, 1000, "kvar", 0, "reactive_effect_in_l2", 0, P1_LINE_NO_GROUP },
+  { "1-0:64.7.0", "Reactive effect in L3", 1040, 64, 19, 1000, "kvar", 0, "reactive_effect_in_l3", 0, P1_LINE_NO_GROUP },
+
+  // Voltage (type 16 = electrical potential) and current (type 5)
+  { "1-0:32.7.0", "Voltage L1", 1040, 16, 20, 1, "V", 0, "voltage_l1", 0, P1_LINE_NO_GROUP },
+  { "1-0:52.7.0", "Voltage L2", 1040, 16, 21, 1, "V", 0, "voltage_l2", 0, P1_LINE_NO_GROUP },
+  { "1-0:72.7.0", "Voltage L3", 1040, 16, 22, 1, "V", 0, "voltage_l3", 0, P1_LINE_NO_GROUP },
+  { "1-0:31.7.0", "Current L1", 1040, 5, 23, 1, "A", 0, "current_l1", 0, P1_LINE_NO_GROUP },
+  { "1-0:51.7.0", "Current L2", 1040, 5, 24, 1, "A", 0, "current_l2", 0, P1_LINE_NO_GROUP },
+  { "1-0:71.7.0", "Current L3", 1040, 5, 25, 1, "A", 0, "current_l3", 0, P1_LINE_NO_GROUP },
+
+  // DSMR tariff registers (tariff 1 = low, tariff 2 = normal)
+  { "1-0:1.8.1", "Energy out tariff 1", 1040, 13, 26, 1, "kWh", 1, "energy_out_t1", 0, P1_LINE_NO_GROUP },
+  { "1-0:1.8.2", "Energy out tariff 2", 1040, 13, 27, 1, "kWh", 1, "energy_out_t2", 0, P1_LINE_NO_GROUP },
+  { "1-0:2.8.1", "Energy in tariff 1", 1040, 13, 28, 1, "kWh", 1, "energy_in_t1", 0, P1_LINE_NO_GROUP },
+  { "1-0:2.8.2", "Energy in tariff 2", 1040, 13, 29, 1, "kWh", 1, "energy_in_t2", 0, P1_LINE_NO_GROUP },
+
+  // Gas meter on M-Bus channel 1 (type 28 = volume).
+  // 0-1:24.2.1(YYMMDDhhmmssX)(value*m3)
+  { "0-1:24.2.1", "Gas delivered", 1040, 28, 30, 1, "m3", 0, "gas", -1, 0 },
+};
+
+/// Number of built in items
+#define DSMR_ITEM_COUNT (sizeof(dsmr_items) / sizeof(dsmr_items[0]))
+
+/*!
+  Compile time version of obis_parse for the tokens in the table.
+  @param p Null terminated OBIS code.
+  @return Key or zero if p is not a valid OBIS code.
+*/
+constexpr uint64_t
+dsmr_obis_key(const char *p)
+{
+  const char sep[] = { '-', ':', '.', '.', '*' };
+  uint64_t val[6]  = { 0, 0, 0, 0, 0, 255 };
+  int group        = 0;
+
+  for (; group < 6; group++) {
+    const char *start = p;
+    while ((*p >= '0') && (*p <= '9')) {
+      val[group] = val[group] * 10 + (*p - '0');
+      if (val[group] > 255) {
+        return 0;
+      }
+      p++;
+    }
+    if ((p == start) || (5 == group) || (sep[group] != *p)) {
+      break;
+    }
+    p++;
+  }
+
+  if ((group < 4) || *p) {
+    return 0;
+  }
+
+  return OBIS_KEY(val[0], val[1], val[2], val[3], val[4], val[5]);
+}
+
+/*!
+  Check the table at compile time. All tokens must be valid OBIS
+  codes and no code may be used twice.
+*/
+constexpr bool
+dsmr_items_valid(void)
+{
+  for (size_t i = 0; i < DSMR_ITEM_COUNT; i++) {
+    uint64_t key = dsmr_obis_key(dsmr_items[i].token);
+    if (!key) {
+      return false;
+    }
+    for (size_t j = i + 1; j < DSMR_ITEM_COUNT; j++) {
+      if (key == dsmr_obis_key(dsmr_items[j].token)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+static_assert(dsmr_items_valid(), "Invalid or duplicate OBIS code in dsmr_items");
+
+#endif // VSCP_DSMR_ITEMS_H__INCLUDED_
@@ -25,6 +25,7 @@
 #include "StdAfx.h"
 #endif
 
+#include <errno.h>
 #include <limits.h>
 #include <pthread.h>
 #include <semaphore.h>
@@ -43,7 +44,9 @@
 #else
 #include <libgen.h>
 #include <net/if.h>
+#include <poll.h>
 #include <signal.h>
+#include <sys/eventfd.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/time.h>
@@ -58,6 +61,7 @@
 #include <expat.h>
 
 #include "alarm.h"
+#include "dsmr-items.h"
 #include "energy-p1-obj.h"
 
 #include <com.h>
@@ -77,6 +81,7 @@
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <list>
@@ -97,6 +102,8 @@ workerThread(void *pData);
 //
 
 CEnergyP1::CEnergyP1()
+  : m_sendQueue(MAX_ITEMS_IN_SEND_QUEUE)
+  , m_receiveQueue(MAX_ITEMS_IN_QUEUE)
 {
   m_bQuit = false;
 
@@ -110,17 +117,40 @@ CEnergyP1::CEnergyP1()
   m_bSerialSwFlowCtrl   = false;
   m_bDtrOnStart         = true;
 
+  // Meter time is CET/CEST by default
+  m_meterUtcOffset = 60;
+  m_bMeterTime     = true;
+
+  m_clockSkew         = 0;
+  m_bClockSkewValid   = false;
+  m_telegramTimestamp = 0;
+  memset(&m_telegramTime, 0, sizeof(m_telegramTime));
+
+  m_bBatch = false;
+  m_batch.reserve(64);
+  m_batchItems.reserve(64);
+
+  m_maxItemsInClientReceiveQueue = MAX_ITEMS_IN_QUEUE;
+  m_queuePolicy                  = P1_QUEUE_DROP_OLDEST;
+  m_bQueueLatest                 = false;
+  m_cntHeldEvents                = 0;
+  m_idxHeldScan                  = 0;
+  m_cntQueueReplaced             = 0;
+  m_bQueueFull                   = false;
+  m_cntQueueDropped              = 0;
+
   vscp_clearVSCPFilter(&m_rxfilter); // Accept all events
   vscp_clearVSCPFilter(&m_txfilter); // Send all events
 
-  sem_init(&m_semSendQueue, 0, 0);
   sem_init(&m_semReceiveQueue, 0, 0);
 
-  pthread_mutex_init(&m_mutexSendQueue, NULL);
-  pthread_mutex_init(&m_mutexReceiveQueue, NULL);
 
-  // Change locale to get the correct decimal point "."
-  setlocale(LC_NUMERIC, "C");
+  // Used to wake up the worker thread when it waits for serial data
+  m_fdWakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  m_pComm    = nullptr;
+
+  // Readable for the host when there are events to read
+  m_fdReceive = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
 
   // Init pool
   spdlog::init_thread_pool(8192, 1);
@@ -159,31 +189,42 @@ CEnergyP1::~CEnergyP1()
   m_bQuit = true;
   pthread_join(m_workerThread, NULL);
 
-  sem_destroy(&m_semSendQueue);
   sem_destroy(&m_semReceiveQueue);
 
-  pthread_mutex_destroy(&m_mutexSendQueue);
-  pthread_mutex_destroy(&m_mutexReceiveQueue);
 
-  // Deallocate ON alarms
-  for (auto const &alarm : m_mapAlarmOn) {
-    delete alarm.second;
+  // Events the host never read
+  vscpEvent *pev;
+  while (nullptr != (pev = m_receiveQueue.pop())) {
+    m_eventPool.release(pev);
+  }
+
+  // Events from the host never handled
+  while (nullptr != (pev = m_sendQueue.pop())) {
+    m_eventPool.releaseLocked(pev);
   }
 
-  m_mapAlarmOn.clear();
+  if (-1 != m_fdWakeup) {
+    ::close(m_fdWakeup);
+    m_fdWakeup = -1;
+  }
 
-  // Deallocate OFF alarms
-  for (auto const &alarm : m_mapAlarmOff) {
-    delete alarm.second;
+  if (-1 != m_fdReceive) {
+    ::close(m_fdReceive);
+    m_fdReceive = -1;
   }
 
-  m_mapAlarmOff.clear();
+  m_listAlarms.clear();
 
   // Deallocate measurement items
   for (auto const &item : m_listItems) {
+    if (nullptr != item->getHeldEvent()) {
+      m_eventPool.release(item->getHeldEvent());
+    }
     delete item;
   }
   m_listItems.clear();
+  m_listPrefixItems.clear();
+  m_obisMap.clear();
 
   // Shutdown logger in a nice way
   spdlog::drop_all();
@@ -239,11 +280,7 @@ CEnergyP1::close(void)
   }
 
   m_bQuit = true; // terminate the thread
-#ifndef WIN32
-  sleep(1); // Give the thread some time to terminate
-#else
-  Sleep(1000);
-#endif
+  wakeupWorker(); // Get it out of poll
 
   pthread_join(m_workerThread, NULL);
 
@@ -285,6 +322,34 @@ CEnergyP1::doLoadConfig(std::string &path)
     spdlog::error("ReadConfig: Failed to read LOGGING 'write' Defaults will be used.");
   }
 
+  // Meter time zone
+  if (m_j_config.contains("meter-utc-offset") && m_j_config["meter-utc-offset"].is_number_integer()) {
+    try {
+      m_meterUtcOffset = m_j_config["meter-utc-offset"].get<int>();
+      spdlog::debug("doLoadConfig: 'meter-utc-offset' {}", m_meterUtcOffset);
+    }
+    catch (const std::exception &ex) {
+      spdlog::error("Failed to read 'meter-utc-offset' Error='{}'", ex.what());
+    }
+    catch (...) {
+      spdlog::error("Failed to read 'meter-utc-offset' due to unknown error.");
+    }
+  }
+
+  // Use meter time for events
+  if (m_j_config.contains("meter-time") && m_j_config["meter-time"].is_boolean()) {
+    try {
+      m_bMeterTime = m_j_config["meter-time"].get<bool>();
+      spdlog::debug("doLoadConfig: 'meter-time' {}", m_bMeterTime);
+    }
+    catch (const std::exception &ex) {
+      spdlog::error("Failed to read 'meter-time' Error='{}'", ex.what());
+    }
+    catch (...) {
+      spdlog::error("Failed to read 'meter-time' due to unknown error.");
+    }
+  }
+
   // VSCP key file
   if (m_j_config.contains("key-file") && m_j_config["key-file"].is_string()) {
     if (!readEncryptionKey(m_j_config["key-file"].get<std::string>())) {
@@ -557,8 +622,16 @@ CEnergyP1::doLoadConfig(std::string &path)
                                                          sinks.end(),
                                                          spdlog::thread_pool(),
                                                          spdlog::async_overflow_policy::block);
-    // The separate sub loggers will handle trace levels
-    logger->set_level(spdlog::level::trace);
+    // The sinks filter on their own level. The logger is set to the lowest
+    // level any sink takes so messages no sink wants are not formatted.
+    spdlog::level::level_enum level = spdlog::level::off;
+    if (m_bConsoleLogEnable) {
+      level = std::min(level, m_consoleLogLevel);
+    }
+    if (m_bFileLogEnable) {
+      level = std::min(level, m_fileLogLevel);
+    }
+    logger->set_level(level);
     logger->flush_on(spdlog::level::debug);
     spdlog::flush_every(std::chrono::seconds(5));
 
@@ -717,15 +790,139 @@ CEnergyP1::doLoadConfig(std::string &path)
       spdlog::warn("ReadConfig: Failed to read 'dtr-on-start' Defaults will be used.");
     }
 
+    // Telegram CRC check
+    if (j.contains("crc-check") && j["crc-check"].is_boolean()) {
+      try {
+        m_telegram.setCrcCheck(j["crc-check"].get<bool>());
+        spdlog::debug("doLoadConfig: 'crc-check' {}", m_telegram.isCrcCheck());
+      }
+      catch (const std::exception &ex) {
+        spdlog::error("ReadConfig: Failed to read 'crc-check' Error='{}'", ex.what());
+      }
+      catch (...) {
+        spdlog::error("ReadConfig: Failed to read 'crc-check' due to unknown error.");
+      }
+    }
+
   } // Serial config
 
+  // * * * Filter * * *
+
+  // Filter for events sent to the host
+  if (m_j_config.contains("filter") && m_j_config["filter"].is_object()) {
+
+    json j = m_j_config["filter"];
+
+    if (j.contains("in-filter") && j["in-filter"].is_string()) {
+      if (!vscp_readFilterFromString(&m_rxfilter, j["in-filter"].get<std::string>())) {
+        spdlog::error("ReadConfig: Failed to read 'in-filter' Defaults will be used.");
+      }
+      else {
+        spdlog::debug("doLoadConfig: 'in-filter' {}", j["in-filter"].get<std::string>());
+      }
+    }
+
+    if (j.contains("in-mask") && j["in-mask"].is_string()) {
+      if (!vscp_readMaskFromString(&m_rxfilter, j["in-mask"].get<std::string>())) {
+        spdlog::error("ReadConfig: Failed to read 'in-mask' Defaults will be used.");
+      }
+      else {
+        spdlog::debug("doLoadConfig: 'in-mask' {}", j["in-mask"].get<std::string>());
+      }
+    }
+  }
+
+  // * * * Receive queue * * *
+
+  // Max number of events waiting for the host
+  if (m_j_config.contains("max-in-queue") && m_j_config["max-in-queue"].is_number()) {
+    int max = m_j_config["max-in-queue"].get<int>();
+    if ((max < 1) || (max > MAX_ITEMS_IN_QUEUE)) {
+      spdlog::warn("ReadConfig: 'max-in-queue' must be 1-{0}. Set to {0}.", MAX_ITEMS_IN_QUEUE);
+      max = MAX_ITEMS_IN_QUEUE;
+    }
+    m_maxItemsInClientReceiveQueue = max;
+    spdlog::debug("doLoadConfig: 'max-in-queue' {}", m_maxItemsInClientReceiveQueue);
+  }
+
+  m_receiveQueue.setLimit(m_maxItemsInClientReceiveQueue);
+
+  // What to drop when the queue is full
+  if (m_j_config.contains("queue-policy") && m_j_config["queue-policy"].is_string()) {
+    std::string str = m_j_config["queue-policy"].get<std::string>();
+    vscp_makeLower(str);
+    if ("drop-oldest" == str) {
+      m_queuePolicy = P1_QUEUE_DROP_OLDEST;
+    }
+    else if ("drop-newest" == str) {
+      m_queuePolicy = P1_QUEUE_DROP_NEWEST;
+    }
+    else if ("latest-per-item" == str) {
+      m_queuePolicy = P1_QUEUE_LATEST_PER_ITEM;
+    }
+    else {
+      spdlog::warn("ReadConfig: Unknown 'queue-policy' {}. Defaults will be used.", str);
+    }
+    spdlog::debug("doLoadConfig: 'queue-policy' {}", m_queuePolicy);
+  }
+
+  // FIFO or only the latest value of each item
+  if (m_j_config.contains("queue-mode") && m_j_config["queue-mode"].is_string()) {
+    std::string str = m_j_config["queue-mode"].get<std::string>();
+    vscp_makeLower(str);
+    if ("fifo" == str) {
+      m_bQueueLatest = false;
+    }
+    else if ("latest" == str) {
+      m_bQueueLatest = true;
+    }
+    else {
+      spdlog::warn("ReadConfig: Unknown 'queue-mode' {}. Defaults will be used.", str);
+    }
+    spdlog::debug("doLoadConfig: 'queue-mode' {}", m_bQueueLatest ? "latest" : "fifo");
+  }
+
   // * * * Items * * *
 
-  if (m_j_config.contains("items") && m_j_config["items"].is_array()) {
+  // The built in DSMR items are used if there is no items array or if
+  // "builtin-items" is true. Items in the array with the same token as
+  // a built in item then override the fields they set.
+  bool bItems        = m_j_config.contains("items") && m_j_config["items"].is_array();
+  bool bBuiltinItems = !bItems;
+  if (m_j_config.contains("builtin-items") && m_j_config["builtin-items"].is_boolean()) {
+    bBuiltinItems = m_j_config["builtin-items"].get<bool>();
+    spdlog::debug("doLoadConfig: 'builtin-items' {}", bBuiltinItems);
+  }
+
+  if (bBuiltinItems && !loadBuiltinItems()) {
+    return false;
+  }
+
+  size_t cntBuiltin = m_listItems.size();
 
-    for (auto it : m_j_config["items"]) {
+  if (bItems || bBuiltinItems) {
+
+    for (auto it : (bItems ? m_j_config["items"] : json::array())) {
+
+      CP1Item *pItem = nullptr;
+      bool bOverride = false;
+
+      // Same token as a built in item?
+      if (cntBuiltin && it.contains("token") && it["token"].is_string()) {
+        std::string token = it["token"].get<std::string>();
+        for (size_t i = 0; i < cntBuiltin; i++) {
+          if (m_listItems[i]->getToken() == token) {
+            pItem     = m_listItems[i];
+            bOverride = true;
+            spdlog::debug("doLoadConfig: Item '{}' overrides built in item.", token);
+            break;
+          }
+        }
+      }
 
-      CP1Item *pItem = new CP1Item;
+      if (nullptr == pItem) {
+        pItem = new CP1Item;
+      }
       if (nullptr == pItem) {
         spdlog::critical("ReadConfig: Unable to allocate data for p1 measurement item.");
         return false;
@@ -744,7 +941,7 @@ CEnergyP1::doLoadConfig(std::string &path)
           spdlog::error("ReadConfig: Failed to read 'token' due to unknown error.");
         }
       }
-      else {
+      else if (!bOverride) {
         spdlog::warn("ReadConfig: Failed to read 'token' Defaults will be used.");
       }
 
@@ -761,7 +958,7 @@ CEnergyP1::doLoadConfig(std::string &path)
           spdlog::error("ReadConfig: Failed to read 'description' due to unknown error.");
         }
       }
-      else {
+      else if (!bOverride) {
         spdlog::warn("ReadConfig: Failed to read 'description' Defaults will be used.");
       }
 
@@ -778,7 +975,7 @@ CEnergyP1::doLoadConfig(std::string &path)
           spdlog::error("ReadConfig: Failed to read 'vscp-class' due to unknown error.");
         }
       }
-      else {
+      else if (!bOverride) {
         spdlog::warn("ReadConfig: Failed to read 'vscp-class' Defaults will be used.");
       }
 
@@ -795,7 +992,7 @@ CEnergyP1::doLoadConfig(std::string &path)
           spdlog::error("ReadConfig: Failed to read 'vscp-type' due to unknown error.");
         }
       }
-      else {
+      else if (!bOverride) {
         spdlog::warn("ReadConfig: Failed to read 'vscp-type' Defaults will be used.");
       }
 
@@ -812,7 +1009,7 @@ CEnergyP1::doLoadConfig(std::string &path)
           spdlog::error("ReadConfig: Failed to read 'sensorindex' due to unknown error.");
         }
       }
-      else {
+      else if (!bOverride) {
         spdlog::warn("ReadConfig: Failed to read 'sensorindex' Defaults will be used.");
       }
 
@@ -829,7 +1026,7 @@ CEnergyP1::doLoadConfig(std::string &path)
           spdlog::error("ReadConfig: Failed to read 'guid-lsb' due to unknown error.");
         }
       }
-      else {
+      else if (!bOverride) {
         spdlog::warn("ReadConfig: Failed to read 'guid-lsb' Defaults will be used.");
       }
 
@@ -846,7 +1043,7 @@ CEnergyP1::doLoadConfig(std::string &path)
           spdlog::error("ReadConfig: Failed to read 'zone' due to unknown error.");
         }
       }
-      else {
+      else if (!bOverride) {
         spdlog::warn("ReadConfig: Failed to read 'zone' Defaults will be used.");
       }
 
@@ -863,12 +1060,12 @@ CEnergyP1::doLoadConfig(std::string &path)
           spdlog::error("ReadConfig: Failed to read 'subzone' due to unknown error.");
         }
       }
-      else {
+      else if (!bOverride) {
         spdlog::warn("ReadConfig: Failed to read 'subzone' Defaults will be used.");
       }
 
       // factor
-      if (it.contains("factor") && it["factor"].is_number_unsigned()) {
+      if (it.contains("factor") && it["factor"].is_number()) {
         try {
           pItem->setFactor(it["factor"].get<double>());
           spdlog::debug("doLoadConfig: 'factor' {}", it["factor"].get<double>());
@@ -880,7 +1077,7 @@ CEnergyP1::doLoadConfig(std::string &path)
           spdlog::error("ReadConfig: Failed to read 'factor' due to unknown error.");
         }
       }
-      else {
+      else if (!bOverride) {
         spdlog::warn("ReadConfig: Failed to read 'factor' Defaults will be used.");
       }
 
@@ -897,10 +1094,77 @@ CEnergyP1::doLoadConfig(std::string &path)
           spdlog::error("ReadConfig: Failed to read 'store' due to unknown error.");
         }
       }
-      else {
+      else if (!bOverride) {
         spdlog::warn("ReadConfig: Failed to read 'store' Defaults will be used.");
       }
 
+      // fixed-point (optional)
+      if (it.contains("fixed-point") && it["fixed-point"].is_boolean()) {
+        try {
+          pItem->setFixedPoint(it["fixed-point"].get<bool>());
+          spdlog::debug("doLoadConfig: 'fixed-point' {}", pItem->isFixedPoint());
+        }
+        catch (const std::exception &ex) {
+          spdlog::error("ReadConfig: Failed to read 'fixed-point' Error='{}'", ex.what());
+        }
+        catch (...) {
+          spdlog::error("ReadConfig: Failed to read 'fixed-point' due to unknown error.");
+        }
+      }
+
+      // value-group (optional)
+      if (it.contains("value-group") && it["value-group"].is_number_integer()) {
+        try {
+          pItem->setValueGroup(it["value-group"].get<int>());
+          spdlog::debug("doLoadConfig: 'value-group' {}", pItem->getValueGroup());
+        }
+        catch (const std::exception &ex) {
+          spdlog::error("ReadConfig: Failed to read 'value-group' Error='{}'", ex.what());
+        }
+        catch (...) {
+          spdlog::error("ReadConfig: Failed to read 'value-group' due to unknown error.");
+        }
+      }
+
+      // time-group (optional)
+      if (it.contains("time-group") && it["time-group"].is_number_integer()) {
+        try {
+          pItem->setTimeGroup(it["time-group"].get<int>());
+          spdlog::debug("doLoadConfig: 'time-group' {}", pItem->getTimeGroup());
+        }
+        catch (const std::exception &ex) {
+          spdlog::error("ReadConfig: Failed to read 'time-group' Error='{}'", ex.what());
+        }
+        catch (...) {
+          spdlog::error("ReadConfig: Failed to read 'time-group' due to unknown error.");
+        }
+      }
+
+      // level1-coding (optional)
+      if (it.contains("level1-coding") && it["level1-coding"].is_string()) {
+        std::string str = it["level1-coding"].get<std::string>();
+        vscp_makeLower(str);
+        if ("string" == str) {
+          pItem->setLevel1Coding(VSCP_DATACODING_STRING);
+        }
+        else if ("integer" == str) {
+          pItem->setLevel1Coding(VSCP_DATACODING_INTEGER);
+        }
+        else if ("normalized" == str) {
+          pItem->setLevel1Coding(VSCP_DATACODING_NORMALIZED);
+        }
+        else if ("single" == str) {
+          pItem->setLevel1Coding(VSCP_DATACODING_SINGLE);
+        }
+        else if ("double" == str) {
+          pItem->setLevel1Coding(VSCP_DATACODING_DOUBLE);
+        }
+        else {
+          spdlog::warn("ReadConfig: Invalid 'level1-coding' '{}' Defaults will be used.", str);
+        }
+        spdlog::debug("doLoadConfig: 'level1-coding' {}", str);
+      }
+
       // units
       if (it.contains("units") && it["units"].is_object()) {
 
@@ -910,7 +1174,9 @@ CEnergyP1::doLoadConfig(std::string &path)
         }
       }
 
-      m_listItems.push_back(pItem);
+      if (!bOverride) {
+        m_listItems.push_back(pItem);
+      }
 
     } // iterator items
 
@@ -921,11 +1187,7 @@ CEnergyP1::doLoadConfig(std::string &path)
       for (auto it : m_j_config["alarms"]) {
 
         std::string strType;
-        CAlarm *pAlarm = new CAlarm;
-        if (nullptr == pAlarm) {
-          spdlog::critical("ReadConfig: Unable to allocate data for p1 measurement item.");
-          return false;
-        }
+        CAlarm alarm;
 
         // Type
         if (it.contains("type") && it["type"].is_string()) {
@@ -948,7 +1210,7 @@ CEnergyP1::doLoadConfig(std::string &path)
         // stored variable to work on
         if (it.contains("variable") && it["variable"].is_string()) {
           try {
-            pAlarm->setVariable(it["variable"].get<std::string>());
+            alarm.setVariable(it["variable"].get<std::string>());
             spdlog::debug("doLoadConfig: 'variable' {}", it["variable"].get<std::string>());
           }
           catch (const std::exception &ex) {
@@ -965,7 +1227,9 @@ CEnergyP1::doLoadConfig(std::string &path)
         // Operation
         if (it.contains("op") && it["op"].is_string()) {
           try {
-            pAlarm->setOperation(it["op"].get<std::string>());
+            if (!alarm.setOperation(it["op"].get<std::string>())) {
+              spdlog::warn("ReadConfig: Unknown 'op' {}. Defaults will be used.", it["op"].get<std::string>());
+            }
             spdlog::debug("doLoadConfig: 'op' {}", it["op"].get<std::string>());
           }
           catch (const std::exception &ex) {
@@ -982,7 +1246,7 @@ CEnergyP1::doLoadConfig(std::string &path)
         // Value
         if (it.contains("value") && it["value"].is_number()) {
           try {
-            pAlarm->setValue(it["value"].get<double>());
+            alarm.setValue(it["value"].get<double>());
             spdlog::debug("doLoadConfig: 'value' {}", it["value"].get<double>());
           }
           catch (const std::exception &ex) {
@@ -999,7 +1263,7 @@ CEnergyP1::doLoadConfig(std::string &path)
         // one-shot
         if (it.contains("one-shot") && it["one-shot"].is_boolean()) {
           try {
-            pAlarm->setOneShot(it["one-shot"].get<bool>());
+            alarm.setOneShot(it["one-shot"].get<bool>());
             spdlog::debug("doLoadConfig: 'one-shot' {}", it["one-shot"].get<bool>());
           }
           catch (const std::exception &ex) {
@@ -1016,7 +1280,7 @@ CEnergyP1::doLoadConfig(std::string &path)
         // Alarm byte
         if (it.contains("alarm-byte") && it["alarm-byte"].is_number_unsigned()) {
           try {
-            pAlarm->setAlarmByte(it["alarm-byte"].get<uint8_t>());
+            alarm.setAlarmByte(it["alarm-byte"].get<uint8_t>());
             spdlog::debug("doLoadConfig: 'alarm-byte' {}", it["alarm-byte"].get<uint8_t>());
           }
           catch (const std::exception &ex) {
@@ -1033,7 +1297,7 @@ CEnergyP1::doLoadConfig(std::string &path)
         // Zone
         if (it.contains("zone") && it["zone"].is_number_unsigned()) {
           try {
-            pAlarm->setZone(it["zone"].get<uint8_t>());
+            alarm.setZone(it["zone"].get<uint8_t>());
             spdlog::debug("doLoadConfig: 'zone' {}", it["zone"].get<uint8_t>());
           }
           catch (const std::exception &ex) {
@@ -1050,7 +1314,7 @@ CEnergyP1::doLoadConfig(std::string &path)
         // Subzone
         if (it.contains("subzone") && it["subzone"].is_number_unsigned()) {
           try {
-            pAlarm->setSubZone(it["subzone"].get<uint8_t>());
+            alarm.setSubZone(it["subzone"].get<uint8_t>());
             spdlog::debug("doLoadConfig: 'subzone' {}", it["subzone"].get<uint8_t>());
           }
           catch (const std::exception &ex) {
@@ -1065,37 +1329,26 @@ CEnergyP1::doLoadConfig(std::string &path)
         }
 
         if ("on" == strType) {
-          if (nullptr == m_mapAlarmOn[pAlarm->getVariable()]) {
-            m_mapAlarmOn[pAlarm->getVariable()] = pAlarm;
-            spdlog::debug("doLoadConfig: 'ON'");
-          }
-          else {
-            spdlog::warn("ReadConfig: Doublet of ON alarms detected [{}]", pAlarm->getVariable());
-            delete pAlarm;
-            pAlarm = nullptr;
-          }
+          alarm.setReset(false);
+          m_listAlarms.push_back(alarm);
+          spdlog::debug("doLoadConfig: 'ON'");
         }
         else if ("off" == strType) {
-          if (nullptr == m_mapAlarmOn[pAlarm->getVariable()]) {
-            m_mapAlarmOff[pAlarm->getVariable()] = pAlarm;
-            spdlog::debug("doLoadConfig: 'OFF'");
-          }
-          else {
-            spdlog::warn("ReadConfig: Doublet of OFF alarms detected [{}]", pAlarm->getVariable());
-            delete pAlarm;
-            pAlarm = nullptr;
-          }
+          alarm.setReset(true);
+          m_listAlarms.push_back(alarm);
+          spdlog::debug("doLoadConfig: 'OFF'");
         }
         else {
-          spdlog::error("ReadConfig: Invalid type = {0} for alarm [{1}}.", strType, pAlarm->getVariable());
-          delete pAlarm;
-          pAlarm = nullptr;
+          spdlog::error("ReadConfig: Invalid type = {0} for alarm [{1}].", strType, alarm.getVariable());
         }
 
       } // iterator alarms
 
     } // Alarms
 
+    // Alarms must be known when the items are indexed
+    buildItemIndex();
+
   } // config
 
   spdlog::debug("doLoadConfig: done");
@@ -1129,108 +1382,117 @@ CEnergyP1::handleHLO(vscpEvent *pEvent)
     return false;
   }
 
+  // Must be HLO command event
+  if ((pEvent->vscp_class != VSCP_CLASS2_HLO) || (pEvent->vscp_type != VSCP2_TYPE_HLO_COMMAND)) {
+    return false;
+  }
+
   // > 18  pos 0-15 = GUID, 16 type >> 4, encryption & 0x0f
   // JSON if type = 2
   // JSON from 17 onwards
 
-  // CHLO hlo;
-  // if (!hlo.parseHLO(j, pEvent )) {
-  spdlog::error("Failed to parse HLO.");
-  //     return false;
-  // }
-
-  // Must be HLO command event
-  if ((pEvent->vscp_class != VSCP_CLASS2_HLO) && (pEvent->vscp_type != VSCP2_TYPE_HLO_COMMAND)) {
+  // GUID + type/encryption + at least one byte of JSON
+  if (pEvent->sizeData < 18) {
+    spdlog::error("HLO handler: Event too short.");
     return false;
   }
 
-  // Get GUID / encryption / type
-  cguid hlo_guid(pEvent->pdata);
-  uint8_t hlo_encryption = pEvent->pdata[16] & 0x0f;
-  uint8_t hlo_type       = (pEvent->pdata[16] >> 4) & 0x0f;
-
   char buf[512];
   memset(buf, 0, sizeof(buf));
-  memcpy(buf, (pEvent->pdata + 17), pEvent->sizeData);
-  auto j = json::parse(buf);
-  printf("%s\n", j.dump().c_str());
+  memcpy(buf, (pEvent->pdata + 17), std::min<size_t>(pEvent->sizeData - 17, sizeof(buf) - 1));
 
-  if (m_j_config["users"].is_array()) {
-    printf("Yes it's an array %zu - %s\n",
-           m_j_config["users"].size(),
-           m_j_config["users"][0]["name"].get<std::string>().c_str());
-  }
-
-  // Must be an operation
-  if (!j["op"].is_string() || j["op"].is_null()) {
-    spdlog::error("HLO-command: Missing op [{}]", j.dump().c_str());
-    return false;
-  }
+  // Runs on the worker thread, nothing the host sends may end it
+  try {
 
-  if (j["arg"].is_object() && !j["arg"].is_null()) {
-    printf("Argument is object\n");
-  }
+    json j = json::parse(buf);
 
-  if (j["arg"].is_string() && !j["arg"].is_null()) {
-    printf("Argument is string\n");
-  }
+    // Must be an operation
+    if (!j.is_object() || !j.contains("op") || !j["op"].is_string()) {
+      spdlog::error("HLO-command: Missing op [{}]", j.dump().c_str());
+      return false;
+    }
 
-  if (j["arg"].is_number() && !j["arg"].is_null()) {
-    printf("Argument is number\n");
-  }
+    std::string op = j["op"].get<std::string>();
 
-  // Make HLO response event
-  ex.obid      = 0;
-  ex.head      = 0;
-  ex.timestamp = vscp_makeTimeStamp();
-  vscp_setEventExToNow(&ex); // Set time to current time
-  ex.vscp_class = VSCP_CLASS2_PROTOCOL;
-  ex.vscp_type  = VSCP2_TYPE_HLO_RESPONSE;
-  m_guid.writeGUID(ex.GUID);
+    // Make HLO response event
+    memset(&ex, 0, sizeof(ex));
+    ex.timestamp = vscp_makeTimeStamp();
+    vscp_setEventExToNow(&ex); // Set time to current time
+    ex.vscp_class = VSCP_CLASS2_PROTOCOL;
+    ex.vscp_type  = VSCP2_TYPE_HLO_RESPONSE;
+    m_guid.writeGUID(ex.GUID);
 
-  json j_response;
+    json j_response;
+    j_response["op"]   = "vscp-reply";
+    j_response["name"] = op;
 
-  if (j.value("op", "") == "noop") {
-    // Send positive response
-    j_response["op"]          = "vscp-reply";
-    j_response["name"]        = "noop";
-    j_response["result"]      = "OK";
-    j_response["description"] = "NOOP commaned executed correctly.";
+    if ("noop" == op) {
+      // Send positive response
+      j_response["result"]      = "OK";
+      j_response["description"] = "NOOP commaned executed correctly.";
+      setReply(ex, j_response);
+    }
+    else if ("readvar" == op) {
+      readVariable(ex, j);
+    }
+    else if ("writevar" == op) {
+      writeVariable(ex, j);
+    }
+    else if ("delvar" == op) {
+      deleteVariable(ex, j);
+    }
+    else if (("load" == op) || ("save" == op) || ("stop" == op) || ("start" == op) || ("restart" == op)) {
+      // Reloading items and alarms or restarting the worker can not be done
+      // from the worker itself. Close and open the driver instead.
+      j_response["result"]      = "ERROR";
+      j_response["description"] = "Operation is not supported while the driver is running.";
+      setReply(ex, j_response);
+    }
+    else if (("dtr" == op) || ("rts" == op)) {
+      // Serial control line, arg true for on
+      bool bOn = j.contains("arg") && j["arg"].is_boolean() && j["arg"].get<bool>();
 
-    memset(ex.data, 0, sizeof(ex.data));
-    ex.sizeData = (uint16_t) strlen(buf);
-    memcpy(ex.data, buf, ex.sizeData);
-  }
-  else if (j.value("op", "") == "readvar") {
-    readVariable(ex, j);
-  }
-  else if (j.value("op", "") == "writevar") {
-    writeVariable(ex, j);
-  }
-  else if (j.value("op", "") == "delvar") {
-    deleteVariable(ex, j);
-  }
-  else if (j.value("op", "") == "load") {
-    std::string path = "";
-    doLoadConfig(path);
-  }
-  else if (j.value("op", "") == "save") {
-    doSaveConfig();
-  }
-  else if (j.value("op", "") == "stop") {
-    stop();
-  }
-  else if (j.value("op", "") == "start") {
-    start();
+      j_response["result"] = setSerialLine(op, bOn) ? "OK" : "ERROR";
+      setReply(ex, j_response);
+    }
+    else {
+      j_response["result"]      = "ERROR";
+      j_response["description"] = "Unknown operation.";
+      setReply(ex, j_response);
+    }
   }
-  else if (j.value("op", "") == "restart") {
-    restart();
+  catch (...) {
+    spdlog::error("HLO handler: Invalid command.");
+    return false;
   }
 
   // Put event in receive queue
   return eventExToReceiveQueue(ex);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// setReply
+//
+
+void
+CEnergyP1::setReply(vscpEventEx &ex, const json &j)
+{
+  std::string str = j.dump();
+
+  // Must fit in the event, tell the caller if it does not
+  if (str.length() > VSCP_MAX_DATA) {
+    spdlog::error("HLO reply too large ({} bytes).", str.length());
+    json jerr;
+    jerr["op"]     = j.value("op", "");
+    jerr["result"] = VSCP_ERROR_ERROR;
+    str            = jerr.dump();
+  }
+
+  memset(ex.data, 0, sizeof(ex.data));
+  ex.sizeData = (uint16_t) str.length();
+  memcpy(ex.data, str.c_str(), ex.sizeData);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // readVariable
 //
@@ -1240,79 +1502,122 @@ CEnergyP1::readVariable(vscpEventEx &ex, const json &json_req)
 {
   json j;
 
+  // Name is in the request, j is the response
+  std::string name = json_req.value("name", "");
+
   j["op"]          = "readvar";
   j["result"]      = VSCP_ERROR_SUCCESS;
-  j["arg"]["name"] = j.value("name", "");
+  j["arg"]["name"] = name;
 
-  if ("debug" == j.value("name", "")) {
+  if ("debug" == name) {
     j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_BOOLEAN;
     j["arg"]["value"] = m_j_config.value("debug", false);
   }
-  else if ("write" == j.value("name", "")) {
+  else if ("write" == name) {
     j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_BOOLEAN;
     j["arg"]["value"] = m_j_config.value("write", false);
   }
-  else if ("interface" == j.value("name", "")) {
+  else if ("interface" == name) {
     j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_STRING;
     j["arg"]["value"] = vscp_convertToBase64(m_j_config.value("interface", ""));
   }
-  else if ("vscp-key-file" == j.value("name", "")) {
+  else if ("vscp-key-file" == name) {
     j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_STRING;
     j["arg"]["value"] = vscp_convertToBase64(m_j_config.value("vscp-key-file", ""));
   }
-  else if ("max-out-queue" == j.value("name", "")) {
+  else if ("max-out-queue" == name) {
     j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_INTEGER;
     j["arg"]["value"] = m_j_config.value("max-out-queue", 0);
   }
-  else if ("max-in-queue" == j.value("name", "")) {
+  else if ("max-in-queue" == name) {
     j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_INTEGER;
     j["arg"]["value"] = m_j_config.value("max-in-queue", 0);
   }
-  else if ("encryption" == j.value("name", "")) {
+  else if ("encryption" == name) {
     j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_STRING;
     j["arg"]["value"] = vscp_convertToBase64(m_j_config.value("encryption", ""));
   }
-  else if ("ssl-certificate" == j.value("name", "")) {
+  else if ("ssl-certificate" == name) {
     j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_STRING;
     j["arg"]["value"] = vscp_convertToBase64(m_j_config.value("ssl-certificate", ""));
   }
-  else if ("ssl-certificate-chain" == j.value("name", "")) {
+  else if ("ssl-certificate-chain" == name) {
     j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_STRING;
     j["arg"]["value"] = vscp_convertToBase64(m_j_config.value("ssl-certificate-chain", ""));
   }
-  else if ("ssl-ca-path" == j.value("name", "")) {
+  else if ("ssl-ca-path" == name) {
     j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_STRING;
     j["arg"]["value"] = vscp_convertToBase64(m_j_config.value("ssl-ca-path", ""));
   }
-  else if ("ssl-ca-file" == j.value("name", "")) {
+  else if ("ssl-ca-file" == name) {
     j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_STRING;
     j["arg"]["value"] = vscp_convertToBase64(m_j_config.value("ssl-ca-file", ""));
   }
-  else if ("ssl-verify-depth" == j.value("name", "")) {
+  else if ("ssl-verify-depth" == name) {
     j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_INTEGER;
     j["arg"]["value"] = m_j_config.value("ssl-verify-depth", 9);
   }
-  else if ("ssl-default-verify-paths" == j.value("name", "")) {
+  else if ("ssl-default-verify-paths" == name) {
     j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_STRING;
     j["arg"]["value"] = vscp_convertToBase64(m_j_config.value("ssl-default-verify-paths", ""));
   }
-  else if ("ssl-cipher-list" == j.value("name", "")) {
+  else if ("ssl-cipher-list" == name) {
     j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_STRING;
     j["arg"]["value"] = vscp_convertToBase64(m_j_config.value("ssl-cipher-list", ""));
   }
-  else if ("ssl-protocol-version" == j.value("name", "")) {
+  else if ("ssl-protocol-version" == name) {
     j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_INTEGER;
     j["arg"]["value"] = m_j_config.value("ssl-protocol-version", 3);
   }
-  else if ("ssl-short-trust" == j.value("name", "")) {
+  else if ("ssl-short-trust" == name) {
     j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_BOOLEAN;
     j["arg"]["value"] = m_j_config.value("ssl-short-trust", false);
   }
-  else if ("user-count" == j.value("name", "")) {
+  else if ("stat-lines" == name) {
+    j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_INTEGER;
+    j["arg"]["value"] = m_framer.getLineCount();
+  }
+  else if ("stat-line-overruns" == name) {
+    j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_INTEGER;
+    j["arg"]["value"] = m_framer.getOverrunCount();
+  }
+  else if ("stat-line-overrun-bytes" == name) {
+    j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_INTEGER;
+    j["arg"]["value"] = m_framer.getOverrunBytes();
+  }
+  else if ("stat-telegrams" == name) {
+    j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_INTEGER;
+    j["arg"]["value"] = m_telegram.getTelegramCount();
+  }
+  else if ("stat-telegram-crc-errors" == name) {
+    j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_INTEGER;
+    j["arg"]["value"] = m_telegram.getCrcErrorCount();
+  }
+  else if ("stat-telegram-overflows" == name) {
+    j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_INTEGER;
+    j["arg"]["value"] = m_telegram.getOverflowCount();
+  }
+  else if ("stat-queue-count" == name) {
+    j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_INTEGER;
+    j["arg"]["value"] = m_receiveQueue.size() + m_cntHeldEvents.load();
+  }
+  else if ("stat-queue-dropped" == name) {
+    j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_INTEGER;
+    j["arg"]["value"] = m_cntQueueDropped;
+  }
+  else if ("stat-queue-replaced" == name) {
+    j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_INTEGER;
+    j["arg"]["value"] = m_cntQueueReplaced;
+  }
+  else if ("stat-clock-skew" == name) {
+    j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_INTEGER;
+    j["arg"]["value"] = m_bClockSkewValid ? m_clockSkew : 0;
+  }
+  else if ("user-count" == name) {
     j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_INTEGER;
     j["arg"]["value"] = 9;
   }
-  else if ("users" == j.value("name", "")) {
+  else if ("users" == name) {
 
     if (!m_j_config["users"].is_array()) {
       spdlog::warn("'users' must be of type array.");
@@ -1320,10 +1625,10 @@ CEnergyP1::readVariable(vscpEventEx &ex, const json &json_req)
       goto abort;
     }
 
-    int index = j.value("index", 0); // get index
-    if (index >= m_j_config["users"].size()) {
+    int index = json_req.value("index", 0); // get index
+    if ((index < 0) || (index >= (int) m_j_config["users"].size())) {
       // Index to large
-      spdlog::warn("index of array is to large [%u].", index >= m_j_config["users"].size());
+      spdlog::warn("index of array is to large [index={0} users-size={1}].", index, m_j_config["users"].size());
       j["result"] = VSCP_ERROR_INDEX_OOB;
       goto abort;
     }
@@ -1333,14 +1638,12 @@ CEnergyP1::readVariable(vscpEventEx &ex, const json &json_req)
   }
   else {
     j["result"] = VSCP_ERROR_MISSING;
-    spdlog::error("Variable [] is unknown.");
+    spdlog::warn("Variable [{}] is unknown.", name.c_str());
   }
 
 abort:
 
-  memset(ex.data, 0, sizeof(ex.data));
-  ex.sizeData = (uint16_t) j.dump().length();
-  memcpy(ex.data, j.dump().c_str(), ex.sizeData);
+  setReply(ex, j);
 
   return true;
 }
@@ -1354,226 +1657,234 @@ CEnergyP1::writeVariable(vscpEventEx &ex, const json &json_req)
 {
   json j;
 
+  // Name and argument are in the request, j is the response
+  std::string name = json_req.value("name", "");
+  json arg         = json_req.value("arg", json());
+
   j["op"]          = "writevar";
   j["result"]      = VSCP_ERROR_SUCCESS;
-  j["arg"]["name"] = j.value("name", "");
+  j["arg"]["name"] = name;
 
-  if ("debug" == j.value("name", "")) {
+  if ("debug" == name) {
 
     // arg should be boolean
-    if (!j["arg"].is_boolean() || j["arg"].is_null()) {
+    if (!arg.is_boolean() || arg.is_null()) {
       j["result"] = VSCP_ERROR_INVALID_TYPE;
       goto abort;
     }
 
     // set new value
-    m_j_config["debug"] = j["arg"].get<bool>();
+    m_j_config["debug"] = arg.get<bool>();
 
     // report back
     j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_BOOLEAN;
     j["arg"]["value"] = m_j_config.value("debug", false);
   }
-  else if ("write" == j.value("name", "")) {
+  else if ("write" == name) {
 
     // arg should be boolean
-    if (!j["arg"].is_boolean() || j["arg"].is_null()) {
+    if (!arg.is_boolean() || arg.is_null()) {
       j["result"] = VSCP_ERROR_INVALID_TYPE;
       goto abort;
     }
     // set new value
-    m_j_config["write"] = j["arg"].get<bool>();
+    m_j_config["write"] = arg.get<bool>();
 
     // report back
     j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_BOOLEAN;
     j["arg"]["value"] = m_j_config.value("write", false);
   }
-  else if ("interface" == j.value("name", "")) {
+  else if ("interface" == name) {
 
     // arg should be string
-    if (!j["arg"].is_string() || j["arg"].is_null()) {
+    if (!arg.is_string() || arg.is_null()) {
       j["result"] = VSCP_ERROR_INVALID_TYPE;
       goto abort;
     }
     // set new value
-    m_j_config["interface"] = j["arg"].get<std::string>();
+    m_j_config["interface"] = arg.get<std::string>();
 
     // report back
     j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_STRING;
     j["arg"]["value"] = vscp_convertToBase64(m_j_config["interface"]);
   }
-  else if ("vscp-key-file" == j.value("name", "")) {
+  else if ("vscp-key-file" == name) {
 
     // arg should be string
-    if (!j["arg"].is_string() || j["arg"].is_null()) {
+    if (!arg.is_string() || arg.is_null()) {
       j["result"] = VSCP_ERROR_INVALID_TYPE;
       goto abort;
     }
     // set new value
-    m_j_config["vscp-key-file"] = j["arg"].get<std::string>();
+    m_j_config["vscp-key-file"] = arg.get<std::string>();
 
     // report back
     j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_STRING;
     j["arg"]["value"] = vscp_convertToBase64(m_j_config.value("vscp-key-file", ""));
   }
-  else if ("max-out-queue" == j.value("name", "")) {
+  else if ("max-out-queue" == name) {
 
     // arg should be number
-    if (!j["arg"].is_number() || j["arg"].is_null()) {
+    if (!arg.is_number() || arg.is_null()) {
       j["result"] = VSCP_ERROR_INVALID_TYPE;
       goto abort;
     }
     // set new value
-    m_j_config["max-out-queue"] = j["arg"].get<int>();
+    m_j_config["max-out-queue"] = arg.get<int>();
 
     // report back
     j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_INTEGER;
     j["arg"]["value"] = m_j_config.value("max-out-queue", 0);
   }
-  else if ("max-in-queue" == j.value("name", "")) {
+  else if ("max-in-queue" == name) {
 
     // arg should be number
-    if (!j["arg"].is_number() || j["arg"].is_null()) {
+    if (!arg.is_number() || arg.is_null()) {
       j["result"] = VSCP_ERROR_INVALID_TYPE;
       goto abort;
     }
     // set new value
-    m_j_config["max-in-queue"] = j["arg"].get<int>();
+    m_j_config["max-in-queue"] = arg.get<int>();
+    if ((arg.get<int>() >= 1) && (arg.get<int>() <= MAX_ITEMS_IN_QUEUE)) {
+      m_maxItemsInClientReceiveQueue = arg.get<int>();
+      m_receiveQueue.setLimit(m_maxItemsInClientReceiveQueue);
+    }
 
     // report back
     j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_INTEGER;
     j["arg"]["value"] = m_j_config.value("max-in-queue", 0);
   }
-  else if ("encryption" == j.value("name", "")) {
+  else if ("encryption" == name) {
 
     // arg should be string
-    if (!j["arg"].is_string() || j["arg"].is_null()) {
+    if (!arg.is_string() || arg.is_null()) {
       j["result"] = VSCP_ERROR_INVALID_TYPE;
       goto abort;
     }
     // set new value
-    m_j_config["encryption"] = j["arg"].get<std::string>();
+    m_j_config["encryption"] = arg.get<std::string>();
 
     // report back
     j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_STRING;
     j["arg"]["value"] = vscp_convertToBase64(m_j_config.value("encryption", ""));
   }
-  else if ("ssl-certificate" == j.value("name", "")) {
+  else if ("ssl-certificate" == name) {
 
     // arg should be string
-    if (!j["arg"].is_string() || j["arg"].is_null()) {
+    if (!arg.is_string() || arg.is_null()) {
       j["result"] = VSCP_ERROR_INVALID_TYPE;
       goto abort;
     }
     // set new value
-    m_j_config["ssl-certificate"] = j["arg"].get<std::string>();
+    m_j_config["ssl-certificate"] = arg.get<std::string>();
 
     // report back
     j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_STRING;
     j["arg"]["value"] = vscp_convertToBase64(m_j_config.value("ssl-certificate", ""));
   }
-  else if ("ssl-certificate-chain" == j.value("name", "")) {
+  else if ("ssl-certificate-chain" == name) {
 
     // arg should be string
-    if (!j["arg"].is_string() || j["arg"].is_null()) {
+    if (!arg.is_string() || arg.is_null()) {
       j["result"] = VSCP_ERROR_INVALID_TYPE;
       goto abort;
     }
     // set new value
-    m_j_config["ssl-certificate-chain"] = j["arg"].get<std::string>();
+    m_j_config["ssl-certificate-chain"] = arg.get<std::string>();
 
     // report back
     j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_STRING;
     j["arg"]["value"] = vscp_convertToBase64(m_j_config.value("ssl-certificate-chain", ""));
   }
-  else if ("ssl-ca-path" == j.value("name", "")) {
+  else if ("ssl-ca-path" == name) {
 
     // arg should be string
-    if (!j["arg"].is_string() || j["arg"].is_null()) {
+    if (!arg.is_string() || arg.is_null()) {
       j["result"] = VSCP_ERROR_INVALID_TYPE;
       goto abort;
     }
     // set new value
-    m_j_config["ssl-ca-path"] = j["arg"].get<std::string>();
+    m_j_config["ssl-ca-path"] = arg.get<std::string>();
 
     // report back
     j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_STRING;
     j["arg"]["value"] = vscp_convertToBase64(m_j_config.value("ssl-ca-path", ""));
   }
-  else if ("ssl-ca-file" == j.value("name", "")) {
+  else if ("ssl-ca-file" == name) {
 
     // arg should be string
-    if (!j["arg"].is_string() || j["arg"].is_null()) {
+    if (!arg.is_string() || arg.is_null()) {
       j["result"] = VSCP_ERROR_INVALID_TYPE;
       goto abort;
     }
     // set new value
-    m_j_config["ssl-ca-file"] = j["arg"].get<std::string>();
+    m_j_config["ssl-ca-file"] = arg.get<std::string>();
 
     // report back
     j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_STRING;
     j["arg"]["value"] = vscp_convertToBase64(m_j_config.value("ssl-ca-file", ""));
   }
-  else if ("ssl-verify-depth" == j.value("name", "")) {
+  else if ("ssl-verify-depth" == name) {
     j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_INTEGER;
     j["arg"]["value"] = m_j_config.value("ssl-verify-depth", 9);
   }
-  else if ("ssl-default-verify-paths" == j.value("name", "")) {
+  else if ("ssl-default-verify-paths" == name) {
 
     // arg should be string
-    if (!j["arg"].is_string() || j["arg"].is_null()) {
+    if (!arg.is_string() || arg.is_null()) {
       j["result"] = VSCP_ERROR_INVALID_TYPE;
       goto abort;
     }
     // set new value
-    m_j_config["ssl-default-verify-paths"] = j["arg"].get<std::string>();
+    m_j_config["ssl-default-verify-paths"] = arg.get<std::string>();
 
     // report back
     j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_STRING;
     j["arg"]["value"] = vscp_convertToBase64(m_j_config.value("ssl-default-verify-paths", ""));
   }
-  else if ("ssl-cipher-list" == j.value("name", "")) {
+  else if ("ssl-cipher-list" == name) {
 
     // arg should be string
-    if (!j["arg"].is_string() || j["arg"].is_null()) {
+    if (!arg.is_string() || arg.is_null()) {
       j["result"] = VSCP_ERROR_INVALID_TYPE;
       goto abort;
     }
     // set new value
-    m_j_config["ssl-cipher-list"] = j["arg"].get<std::string>();
+    m_j_config["ssl-cipher-list"] = arg.get<std::string>();
 
     // report back
     j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_STRING;
     j["arg"]["value"] = vscp_convertToBase64(m_j_config.value("ssl-cipher-list", ""));
   }
-  else if ("ssl-protocol-version" == j.value("name", "")) {
+  else if ("ssl-protocol-version" == name) {
 
     // arg should be number
-    if (!j["arg"].is_number() || j["arg"].is_null()) {
+    if (!arg.is_number() || arg.is_null()) {
       j["result"] = VSCP_ERROR_INVALID_TYPE;
       goto abort;
     }
     // set new value
-    m_j_config["ssl-protocol-version"] = j["arg"].get<bool>();
+    m_j_config["ssl-protocol-version"] = arg.get<bool>();
 
     // report back
     j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_INTEGER;
     j["arg"]["value"] = m_j_config.value("ssl-protocol-version", 3);
   }
-  else if ("ssl-short-trust" == j.value("name", "")) {
+  else if ("ssl-short-trust" == name) {
 
     // arg should be boolean
-    if (!j["arg"].is_boolean() || j["arg"].is_null()) {
+    if (!arg.is_boolean() || arg.is_null()) {
       j["result"] = VSCP_ERROR_INVALID_TYPE;
       goto abort;
     }
     // set new value
-    m_j_config["ssl-short-trust"] = j["arg"].get<bool>();
+    m_j_config["ssl-short-trust"] = arg.get<bool>();
 
     // report back
     j["arg"]["type"]  = VSCP_REMOTE_VARIABLE_CODE_BOOLEAN;
     j["arg"]["value"] = m_j_config.value("ssl-short-trust", false);
   }
-  else if ("users" == j.value("name", "")) {
+  else if ("users" == name) {
 
     // users must be array
     if (!m_j_config["users"].is_array()) {
@@ -1583,21 +1894,21 @@ CEnergyP1::writeVariable(vscpEventEx &ex, const json &json_req)
     }
 
     // Must be object
-    if (!m_j_config["args"].is_object()) {
+    if (!json_req.value("args", json()).is_object()) {
       spdlog::warn("The user info must be an object.");
       j["result"] = VSCP_ERROR_INVALID_TYPE;
       goto abort;
     }
 
-    int index = j.value("index", 0); // get index
-    if (index >= m_j_config["users"].size()) {
+    int index = json_req.value("index", 0); // get index
+    if ((index < 0) || (index >= (int) m_j_config["users"].size())) {
       // Index to large
       spdlog::warn("index of array is to large [index={0} users-size={1}].", index, m_j_config["users"].size());
       j["result"] = VSCP_ERROR_INDEX_OOB;
       goto abort;
     }
 
-    m_j_config["users"][index] = j["args"];
+    m_j_config["users"][index] = json_req.value("args", json());
 
     j["arg"]["type"]  = 99 /*VSCP_REMOTE_VARIABLE_CODE_JSON TODO*/;
     j["arg"]["value"] = m_j_config["users"][index].dump();
@@ -1609,9 +1920,7 @@ CEnergyP1::writeVariable(vscpEventEx &ex, const json &json_req)
 
 abort:
 
-  memset(ex.data, 0, sizeof(ex.data));
-  ex.sizeData = (uint16_t) j.dump().length();
-  memcpy(ex.data, j.dump().c_str(), ex.sizeData);
+  setReply(ex, j);
 
   return true;
 }
@@ -1621,15 +1930,18 @@ abort:
 //
 
 bool
-CEnergyP1::deleteVariable(vscpEventEx &ex, const json &json_reg)
+CEnergyP1::deleteVariable(vscpEventEx &ex, const json &json_req)
 {
   json j;
 
+  // Name is in the request, j is the response
+  std::string name = json_req.value("name", "");
+
   j["op"]          = "deletevar";
   j["result"]      = VSCP_ERROR_SUCCESS;
-  j["arg"]["name"] = j.value("name", "");
+  j["arg"]["name"] = name;
 
-  if ("users" == j.value("name", "")) {
+  if ("users" == name) {
 
     // users must be array
     if (!m_j_config["users"].is_array()) {
@@ -1638,15 +1950,8 @@ CEnergyP1::deleteVariable(vscpEventEx &ex, const json &json_reg)
       goto abort;
     }
 
-    // Must be object
-    if (!m_j_config["args"].is_object()) {
-      spdlog::warn("The user info must be an object.");
-      j["result"] = VSCP_ERROR_INVALID_TYPE;
-      goto abort;
-    }
-
-    int index = j.value("index", 0); // get index
-    if (index >= m_j_config["users"].size()) {
+    int index = json_req.value("index", 0); // get index
+    if ((index < 0) || (index >= (int) m_j_config["users"].size())) {
       // Index to large
       spdlog::warn("index of array is to large [index={0} users-size={1}].", index, m_j_config["users"].size());
       j["result"] = VSCP_ERROR_INDEX_OOB;
@@ -1657,14 +1962,12 @@ CEnergyP1::deleteVariable(vscpEventEx &ex, const json &json_reg)
   }
   else {
     j["result"] = VSCP_ERROR_MISSING;
-    spdlog::warn("Variable [{}] is unknown.", j.value("name", "").c_str());
+    spdlog::warn("Variable [{}] is unknown.", name.c_str());
   }
 
 abort:
 
-  memset(ex.data, 0, sizeof(ex.data));
-  ex.sizeData = (uint16_t) j.dump().length();
-  memcpy(ex.data, j.dump().c_str(), ex.sizeData);
+  setReply(ex, j);
 
   return true;
 }
@@ -1708,382 +2011,417 @@ CEnergyP1::restart(void)
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-// doWork
+// loadBuiltinItems
 //
 
 bool
-CEnergyP1::doWork(std::string &strbuf)
+CEnergyP1::loadBuiltinItems(void)
 {
-  // Check for a full line of input
-  size_t pos_find;
-  std::string exstr;
-  std::string valstr;
+  for (size_t i = 0; i < DSMR_ITEM_COUNT; i++) {
 
-  if (std::string::npos != (pos_find = strbuf.find("("))) {
-    spdlog::trace("Working thread: Line {}", strbuf);
-    exstr  = strbuf.substr(0, pos_find);
-    valstr = strbuf.substr(pos_find + 2);
-  }
-  else {
-    return false;
+    const dsmr_item &def = dsmr_items[i];
+
+    CP1Item *pItem = new CP1Item;
+    if (nullptr == pItem) {
+      spdlog::critical("loadBuiltinItems: Unable to allocate data for p1 measurement item.");
+      return false;
+    }
+
+    pItem->setToken(def.token);
+    pItem->setDescription(def.description);
+    pItem->setVscpClass(def.vscpClass);
+    pItem->setVscpType(def.vscpType);
+    pItem->setSensorIndex(def.sensorIndex);
+    pItem->setGuidLsb(def.sensorIndex);
+    pItem->setFactor(def.factor);
+    pItem->addUnit(def.unit, def.vscpUnit);
+    pItem->setStorageName(def.store);
+    pItem->setValueGroup(def.valueGroup);
+    pItem->setTimeGroup(def.timeGroup);
+
+    m_listItems.push_back(pItem);
   }
 
-  spdlog::trace("exstr={0} valstr={1} strbuf={2}", exstr, valstr, strbuf);
+  spdlog::debug("loadBuiltinItems: {} built in DSMR items loaded.", DSMR_ITEM_COUNT);
+
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// buildItemIndex
+//
+
+void
+CEnergyP1::buildItemIndex(void)
+{
+  m_obisMap.clear();
+  m_listPrefixItems.clear();
+
+  uint8_t guid[16];
+  m_guid.writeGUID(guid);
 
   for (auto const &pItem : m_listItems) {
+    uint64_t key;
+    pItem->buildEventTemplate(guid);
+    if (!pItem->hasEncoder()) {
+      spdlog::warn("buildItemIndex: Class {0} with coding {1:#x} is not supported for token '{2}'. No events sent.",
+                   pItem->getVscpClass(),
+                   pItem->getLevel1Coding(),
+                   pItem->getToken());
+    }
+
+    // Run the receive filter on the event once here instead of on
+    // every event. Items with nothing to send and no alarms are
+    // skipped before the value is parsed.
+    vscpEventEx ex;
+    vscpEvent ev;
+    pItem->initEventEx(ex);
+    memset(&ev, 0, sizeof(ev));
+    ev.head       = ex.head;
+    ev.vscp_class = ex.vscp_class;
+    ev.vscp_type  = ex.vscp_type;
+    memcpy(ev.GUID, ex.GUID, 16);
+    pItem->setFiltered(!vscp_doLevel2Filter(&ev, &m_rxfilter));
+
+    // Alarms on the value of the item with their events built and
+    // filtered here. Items without alarms have an empty vector.
+    pItem->getAlarms().clear();
+    for (auto const &alarm : m_listAlarms) {
+      if (alarm.getVariable() != pItem->getStorageName()) {
+        continue;
+      }
+
+      CAlarm itemAlarm = alarm;
+      itemAlarm.buildEvent(guid, pItem->getGuidLsb());
+
+      const vscpEventEx &exAlarm = itemAlarm.getEventEx();
+      ev.head       = exAlarm.head;
+      ev.vscp_class = exAlarm.vscp_class;
+      ev.vscp_type  = exAlarm.vscp_type;
+      memcpy(ev.GUID, exAlarm.GUID, 16);
+      if (!vscp_doLevel2Filter(&ev, &m_rxfilter)) {
+        spdlog::debug("buildItemIndex: Alarm for '{}' is filtered out.", alarm.getVariable());
+        continue;
+      }
+
+      pItem->getAlarms().push_back(itemAlarm);
+    }
+
+    pItem->setActive(pItem->hasAlarms() || (!pItem->isFiltered() && pItem->hasEncoder()));
+    if (!pItem->isActive()) {
+      spdlog::debug("buildItemIndex: Token '{}' is filtered out and has no alarms.", pItem->getToken());
+    }
+    const std::string &token = pItem->getToken();
+    if (token.length() && (token.length() == obis_parse(token.data(), token.length(), &key))) {
+      m_obisMap.add(key, pItem);
+    }
+    else {
+      spdlog::debug("buildItemIndex: Token '{}' is not an OBIS code, matched on prefix.", token);
+      m_listPrefixItems.push_back(pItem);
+    }
+  }
 
-    if (exstr.rfind(pItem->getToken(), 0) == 0) {
+  m_obisMap.build();
 
-      // Initialize new event
-      vscpEventEx ex = { 0 };
-      ex.head        = VSCP_HEADER16_GUID_TYPE_STANDARD | VSCP_PRIORITY_NORMAL | VSCP_HEADER16_DUMB;
-      double value   = pItem->getValue(strbuf);
+  spdlog::debug("buildItemIndex: {0} OBIS codes {1}, {2} prefix items.",
+                m_obisMap.getKeyCount(),
+                m_obisMap.isPerfect() ? "(perfect hash)" : "(probing)",
+                m_listPrefixItems.size());
+}
 
-      spdlog::trace("MATCH! - Found token={0} value={1} unit={2} - {3}",
-                    pItem->getToken(),
-                    pItem->getValue(strbuf),
-                    pItem->getUnit(strbuf),
-                    strbuf);
+///////////////////////////////////////////////////////////////////////////////
+// doTelegram
+//
 
-      if (m_bDebug) {
-        ;
-      }
+bool
+CEnergyP1::doTelegram(const CP1Telegram &telegram)
+{
+  const char *pline;
+  size_t len;
 
-      // Save measurement value
-      m_lastValue[pItem->getStorageName()] = value;
-
-      switch (pItem->getVscpClass()) {
-
-        case VSCP_CLASS1_MEASUREMENT: {
-
-          switch (pItem->getLevel1Coding()) {
-
-            case VSCP_DATACODING_STRING: {
-              if (!vscp_makeStringMeasurementEventEx(&ex,
-                                                     (float) value,
-                                                     pItem->getSensorIndex(),
-                                                     pItem->getUnit(strbuf))) {
-                break;
-              }
-            } break;
-
-            case VSCP_DATACODING_INTEGER: {
-              uint64_t val64 = value;
-              if (!vscp_convertIntegerToNormalizedEventData(ex.data,
-                                                            &ex.sizeData,
-                                                            val64,
-                                                            pItem->getUnit(strbuf),
-                                                            pItem->getSensorIndex())) {
-                break;
-              }
-            } break;
-
-            case VSCP_DATACODING_NORMALIZED: {
-              uint64_t val64 = value;
-              if (!vscp_convertIntegerToNormalizedEventData(ex.data,
-                                                            &ex.sizeData,
-                                                            val64,
-                                                            pItem->getUnit(strbuf),
-                                                            pItem->getSensorIndex())) {
-                break;
-              }
-            } break;
-
-            case VSCP_DATACODING_SINGLE:
-              if (!vscp_makeFloatMeasurementEventEx(&ex,
-                                                    (float) value,
-                                                    pItem->getSensorIndex(),
-                                                    pItem->getUnit(strbuf))) {
-                break;
-              }
-              break;
-
-            case VSCP_DATACODING_DOUBLE:
-              break;
-          }
+  // Time for all events from this telegram
+  updateTelegramTime(&telegram);
 
-        } break;
+  // All events from the telegram are put on the queue at once
+  m_bBatch = true;
 
-        case VSCP_CLASS1_MEASUREMENT64: {
-          if (!vscp_makeFloatMeasurementEventEx(&ex, (float) value, pItem->getSensorIndex(), pItem->getUnit(strbuf))) {
-            break;
-          }
-        } break;
-
-        case VSCP_CLASS1_MEASUREZONE: {
-        } break;
-
-        case VSCP_CLASS1_MEASUREMENT32: {
-        } break;
-
-        case VSCP_CLASS1_SETVALUEZONE: {
-        } break;
-
-        case VSCP_CLASS2_MEASUREMENT_STR: {
-
-          if (vscp_makeLevel2StringMeasurementEventEx(&ex,
-                                                      pItem->getVscpType(),
-                                                      value,
-                                                      pItem->getUnit(strbuf),
-                                                      pItem->getSensorIndex(),
-                                                      pItem->getZone(),
-                                                      pItem->getSubZone())) {
-
-            ex.timestamp = vscp_makeTimeStamp();
-            vscp_setEventExDateTimeBlockToNow(&ex);
-            ex.vscp_class = pItem->getVscpClass();
-            ex.vscp_type  = pItem->getVscpType();
-            m_guid.writeGUID(ex.GUID);
-            ex.GUID[15] = pItem->getGuidLsb();
-
-            vscpEvent *pEvent = new vscpEvent;
-            if (nullptr != pEvent) {
-              pEvent->pdata    = nullptr;
-              pEvent->sizeData = 0;
-              vscp_convertEventExToEvent(pEvent, &ex);
-              if (!addEvent2ReceiveQueue(pEvent)) {
-                spdlog::error("Failed to add event to receive queue.");
-              }
-              else {
-                spdlog::debug("Event added to receive queue class={0} type={1}", ex.vscp_class, ex.vscp_type);
-              }
-            }
-            else {
-              spdlog::error("Failed to allocate memory for event.");
-            }
-          }
-          else {
-            spdlog::error("Failed to build level II string measurement event.");
-          }
-        } break;
-
-        case VSCP_CLASS2_MEASUREMENT_FLOAT: {
-
-          if (!vscp_makeLevel2FloatMeasurementEventEx(&ex,
-                                                      pItem->getVscpType(),
-                                                      value,
-                                                      pItem->getUnit(strbuf),
-                                                      pItem->getSensorIndex(),
-                                                      pItem->getZone(),
-                                                      pItem->getSubZone())) {
-
-            ex.timestamp = vscp_makeTimeStamp();
-            vscp_setEventExDateTimeBlockToNow(&ex);
-            ex.vscp_class = pItem->getVscpClass();
-            ex.vscp_type  = pItem->getVscpType();
-            m_guid.writeGUID(ex.GUID);
-            ex.GUID[15] = pItem->getGuidLsb();
-
-            vscpEvent *pEvent = new vscpEvent;
-            if (nullptr != pEvent) {
-              pEvent->pdata    = nullptr;
-              pEvent->sizeData = 0;
-              vscp_convertEventExToEvent(pEvent, &ex);
-              if (!addEvent2ReceiveQueue(pEvent)) {
-                spdlog::error("Failed to add event to receive queue.");
-              }
-              else {
-                spdlog::debug("Event added to receive queue class={0} type={1}", ex.vscp_class, ex.vscp_type);
-              }
-            }
-            else {
-              spdlog::error("Failed to allocate memory for event.");
-            }
-          }
-          else {
-            spdlog::error("Failed to build level II string measurement event.");
-          }
-        } break;
-      }
-
-      // Check Alarm ON
-      CAlarm *pAlarm;
-      if (nullptr != (pAlarm = m_mapAlarmOn[pItem->getStorageName()])) {
-
-        if (alarm_op::gt == pAlarm->getOp()) {
-          if ((pAlarm->getValue() > value) && !(pAlarm->isSent() && pAlarm->isOneShot())) {
-
-            // Send alarm
-            vscpEventEx ex;
-            ex.head      = VSCP_HEADER16_GUID_TYPE_STANDARD | VSCP_PRIORITY_NORMAL | VSCP_HEADER16_DUMB;
-            ex.timestamp = vscp_makeTimeStamp();
-            vscp_setEventExDateTimeBlockToNow(&ex);
-            ex.vscp_class = VSCP_CLASS1_ALARM;
-            ex.vscp_type  = VSCP_TYPE_ALARM_ALARM;
-            m_guid.writeGUID(ex.GUID);
-            ex.GUID[15] = pItem->getGuidLsb();
-            ex.sizeData = 3;
-            ex.data[0]  = pAlarm->getAlarmByte();
-            ex.data[1]  = pAlarm->getZone();
-            ex.data[2]  = pAlarm->getSubZone();
-
-            vscpEvent *pEvent = new vscpEvent;
-            if (nullptr != pEvent) {
-              pEvent->pdata    = nullptr;
-              pEvent->sizeData = 0;
-              vscp_convertEventExToEvent(pEvent, &ex);
-              if (!addEvent2ReceiveQueue(pEvent)) {
-                spdlog::error("AlarmOn: Failed to add event to receive queue.");
-              }
-              else {
-                spdlog::debug("Sent ON alarm [{}]", pAlarm->getVariable());
-                pAlarm->setSentFlag();
-              }
-            }
-            else {
-              spdlog::error("AlarmOn: Failed to allocate memory for event.");
-            }
-          }
-        }
-        else if (alarm_op::lt == pAlarm->getOp()) {
-
-          if (pAlarm->getValue() < value) {
-
-            // send alarm
-            vscpEventEx ex;
-            ex.head      = VSCP_HEADER16_GUID_TYPE_STANDARD | VSCP_PRIORITY_NORMAL | VSCP_HEADER16_DUMB;
-            ex.timestamp = vscp_makeTimeStamp();
-            vscp_setEventExDateTimeBlockToNow(&ex);
-            ex.vscp_class = VSCP_CLASS1_ALARM;
-            ex.vscp_type  = VSCP_TYPE_ALARM_ALARM;
-            m_guid.writeGUID(ex.GUID);
-            ex.GUID[15] = pItem->getGuidLsb();
-            ex.sizeData = 3;
-            ex.data[0]  = pAlarm->getAlarmByte();
-            ex.data[1]  = pAlarm->getZone();
-            ex.data[2]  = pAlarm->getSubZone();
-
-            vscpEvent *pEvent = new vscpEvent;
-            if (nullptr != pEvent) {
-              pEvent->pdata    = nullptr;
-              pEvent->sizeData = 0;
-              vscp_convertEventExToEvent(pEvent, &ex);
-              if (!addEvent2ReceiveQueue(pEvent)) {
-                spdlog::error("AlarmOff: Failed to add event to receive queue.");
-              }
-              else {
-                spdlog::debug("Sent OFF alarm [{}]", pAlarm->getVariable());
-                pAlarm->setSentFlag();
-                // Reset Possible OFF flag
-              }
-            }
-            else {
-              spdlog::error("AlarmOn: Failed to allocate memory for event.");
-            }
-          }
-        }
-      }
+  // First line is the header and last line the CRC line
+  for (size_t i = 1; (i + 1) < telegram.getLineCount(); i++) {
+    CP1Line line;
+    size_t cnt;
+    const uint32_t *pdelims = telegram.getLineDelimiters(i, &cnt);
+    pline                   = telegram.getLine(i, &len);
+    if (line.parse(pline, len, pdelims, cnt, telegram.getLineOffset(i))) {
+      doLine(line);
+    }
+  }
 
-      // Check Alarm OFF
-      if (nullptr != (pAlarm = m_mapAlarmOff[pItem->getStorageName()])) {
-
-        if (alarm_op::gt == pAlarm->getOp()) {
-
-          if ((pAlarm->getValue() > value) && !(pAlarm->isSent() && pAlarm->isOneShot())) {
-
-            // Send alarm
-            vscpEventEx ex;
-            ex.head      = VSCP_HEADER16_GUID_TYPE_STANDARD | VSCP_PRIORITY_NORMAL | VSCP_HEADER16_DUMB;
-            ex.timestamp = vscp_makeTimeStamp();
-            vscp_setEventExDateTimeBlockToNow(&ex);
-            ex.vscp_class = VSCP_CLASS1_ALARM;
-            ex.vscp_type  = VSCP_TYPE_ALARM_RESET;
-            // memcpy(ex.GUID, pObj->m_guid.m_id, 16);
-            m_guid.writeGUID(ex.GUID);
-            ex.GUID[15] = pItem->getGuidLsb();
-            ex.sizeData = 3;
-            ex.data[0]  = pAlarm->getAlarmByte();
-            ex.data[1]  = pAlarm->getZone();
-            ex.data[2]  = pAlarm->getSubZone();
-
-            vscpEvent *pEvent = new vscpEvent;
-            if (nullptr != pEvent) {
-              pEvent->pdata    = nullptr;
-              pEvent->sizeData = 0;
-              vscp_convertEventExToEvent(pEvent, &ex);
-              if (!addEvent2ReceiveQueue(pEvent)) {
-                spdlog::error("AlarmOn: Failed to add event to receive queue.");
-              }
-              else {
-                spdlog::debug("Sent ON alarm [{}]", pAlarm->getVariable());
-                pAlarm->setSentFlag();
-              }
-            }
-            else {
-              spdlog::error("AlarmOn: Failed to allocate memory for event.");
-            }
-          }
-        }
-        else if (alarm_op::lt == pAlarm->getOp()) {
-
-          if (pAlarm->getValue() < value) {
-
-            // send alarm
-            vscpEventEx ex;
-            ex.head      = VSCP_HEADER16_GUID_TYPE_STANDARD | VSCP_PRIORITY_NORMAL | VSCP_HEADER16_DUMB;
-            ex.timestamp = vscp_makeTimeStamp();
-            vscp_setEventExDateTimeBlockToNow(&ex);
-            ex.vscp_class = VSCP_CLASS1_ALARM;
-            ex.vscp_type  = VSCP_TYPE_ALARM_ALARM;
-            // memcpy(ex.GUID, pObj->m_guid.m_id, 16);
-            m_guid.writeGUID(ex.GUID);
-            ex.GUID[15] = pItem->getGuidLsb();
-            ex.sizeData = 3;
-            ex.data[0]  = pAlarm->getAlarmByte();
-            ex.data[1]  = pAlarm->getZone();
-            ex.data[2]  = pAlarm->getSubZone();
-
-            vscpEvent *pEvent = new vscpEvent;
-            if (nullptr != pEvent) {
-              pEvent->pdata    = nullptr;
-              pEvent->sizeData = 0;
-              vscp_convertEventExToEvent(pEvent, &ex);
-              if (!addEvent2ReceiveQueue(pEvent)) {
-                spdlog::error("AlarmOff: Failed to add event to receive queue.");
-              }
-              else {
-                spdlog::debug("Sent OFF alarm [{}]", pAlarm->getVariable());
-                pAlarm->setSentFlag();
-                // Reset Possible ON flag
-              }
-            }
-            else {
-              spdlog::error("AlarmOn: Failed to allocate memory for event.");
-            }
+  m_bBatch = false;
+  publishBatch();
+
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// doWork
+//
+
+bool
+CEnergyP1::doWork(const char *pbuf, size_t len)
+{
+  CP1Line line;
+
+  // Split line in id, value and unit. Nothing is copied.
+  if (!line.parse(pbuf, len)) {
+    return false;
+  }
+
+  return doLine(line);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// doLine
+//
+
+bool
+CEnergyP1::doLine(const CP1Line &line)
+{
+  // Formatting costs even when no sink takes trace, only do it when asked for
+  if (spdlog::should_log(spdlog::level::trace)) {
+    spdlog::trace("Working thread: Line {}", spdlog::string_view_t(line.getLine(), line.getLineLength()));
+  }
+
+  // Items with a full OBIS code as token
+  uint64_t key;
+  CP1Item *const *ppItems;
+  size_t cnt = 0;
+  if (line.getIdLength() == obis_parse(line.getId(), line.getIdLength(), &key)) {
+    cnt = m_obisMap.find(key, &ppItems);
+  }
+
+  for (size_t i = 0; i < cnt; i++) {
+    if (ppItems[i]->isActive()) {
+      doItem(ppItems[i], line);
+    }
+  }
+
+  // Items with any other token is matched on the start of the line
+  for (auto const &pItem : m_listPrefixItems) {
+    const std::string &token = pItem->getToken();
+    if (pItem->isActive() && (token.length() <= line.getIdLength()) &&
+        (0 == memcmp(token.data(), line.getId(), token.length()))) {
+      doItem(pItem, line);
+    }
+  }
+
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// setEventTime
+//
+
+void
+CEnergyP1::setEventTime(vscpEventEx &ex, CP1Item *pItem, const CP1Line &line)
+{
+  int64_t t;
+
+  // Use the time the meter has given the value if there is one
+  if (pItem->getTime(line, m_meterUtcOffset, &t)) {
+    p1_datetime dt;
+    p1_datetime_from_epoch(t, &dt);
+    ex.timestamp = m_telegramTimestamp;
+    ex.year      = dt.year;
+    ex.month     = dt.month;
+    ex.day       = dt.day;
+    ex.hour      = dt.hour;
+    ex.minute    = dt.minute;
+    ex.second    = dt.second;
+  }
+  else {
+    setTelegramTime(ex);
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// setTelegramTime
+//
+
+void
+CEnergyP1::setTelegramTime(vscpEventEx &ex)
+{
+  ex.timestamp = m_telegramTimestamp;
+  ex.year      = m_telegramTime.year;
+  ex.month     = m_telegramTime.month;
+  ex.day       = m_telegramTime.day;
+  ex.hour      = m_telegramTime.hour;
+  ex.minute    = m_telegramTime.minute;
+  ex.second    = m_telegramTime.second;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// updateTelegramTime
+//
+
+void
+CEnergyP1::updateTelegramTime(const CP1Telegram *ptelegram)
+{
+  struct timespec now;
+
+  // The only clock read for all events from this telegram
+  clock_gettime(CLOCK_REALTIME, &now);
+  m_telegramTimestamp = (uint32_t) ((uint64_t) now.tv_sec * 1000000 + now.tv_nsec / 1000);
+
+  int64_t t = now.tv_sec;
+
+  // Look for the telegram time stamp 0-0:1.0.0(YYMMDDhhmmssX)
+  if (nullptr != ptelegram) {
+    for (size_t i = 1; (i + 1) < ptelegram->getLineCount(); i++) {
+      size_t len;
+      const char *pline = ptelegram->getLine(i, &len);
+      if ((len > 10) && (0 == memcmp(pline, "0-0:1.0.0(", 10))) {
+        int64_t meterTime;
+        const char *pend = (const char *) memchr(pline + 10, ')', len - 10);
+        if ((nullptr != pend) && p1_parse_timestamp(pline + 10, pend - (pline + 10), m_meterUtcOffset, &meterTime)) {
+          m_clockSkew       = now.tv_sec - meterTime;
+          m_bClockSkewValid = true;
+          if (m_bMeterTime) {
+            t = meterTime;
           }
+          spdlog::trace("Telegram time {0} host clock skew {1} s", meterTime, m_clockSkew);
         }
+        break;
       }
-    } // if match
-  }   // Iterate
+    }
+  }
 
-  return true;
+  p1_datetime_from_epoch(t, &m_telegramTime);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-// eventExToReceiveQueue
+// doItem
 //
 
 bool
-CEnergyP1::eventExToReceiveQueue(vscpEventEx &ex)
+CEnergyP1::doItem(CP1Item *pItem, const CP1Line &line)
 {
-  vscpEvent *pev = new vscpEvent();
-  pev->pdata     = nullptr;
-  pev->sizeData  = 0;
-  if (!vscp_convertEventExToEvent(pev, &ex)) {
-    spdlog::error("Failed to convert event from ex to ev.");
-    vscp_deleteEvent(pev);
+  double value;
+  p1_fixed fixed = { 0, 0 };
+  if (pItem->isEncodeFixed()) {
+    if (!pItem->getFixedValue(line, &fixed)) {
+      spdlog::warn("Invalid value for token={0} - {1}",
+                   pItem->getToken(),
+                   spdlog::string_view_t(line.getLine(), line.getLineLength()));
+      return false;
+    }
+    value = p1_fixed_to_double(fixed);
+  }
+  else if (!pItem->getValue(line, &value)) {
+    spdlog::warn("Invalid value for token={0} - {1}",
+                 pItem->getToken(),
+                 spdlog::string_view_t(line.getLine(), line.getLineLength()));
     return false;
   }
 
-  if (NULL != pev) {
-    if (vscp_doLevel2Filter(pev, &m_rxfilter)) {
-      pthread_mutex_lock(&m_mutexReceiveQueue);
-      m_receiveList.push_back(pev);
-      pthread_mutex_unlock(&m_mutexReceiveQueue);
-      sem_post(&m_semReceiveQueue);
+  // Unit code, looked up once
+  int unit = pItem->getUnit(line);
+
+  // Initialize new event from the template of the item
+  vscpEventEx ex;
+  uint16_t pos = pItem->initEventEx(ex);
+
+  if (spdlog::should_log(spdlog::level::trace)) {
+    spdlog::trace("MATCH! - Found token={0} value={1} unit={2} - {3}",
+                  pItem->getToken(),
+                  value,
+                  unit,
+                  spdlog::string_view_t(line.getLine(), line.getLineLength()));
+  }
+
+  // Value bytes for the class and coding of the item
+  if (pItem->hasEncoder() && !pItem->isFiltered()) {
+    p1_value val = { value, fixed };
+    if (pItem->encode(ex, pos, val, unit)) {
+      measurementToReceiveQueue(ex, pItem, line);
     }
     else {
-      vscp_deleteEvent(pev);
+      spdlog::error("Failed to build measurement event for token={0} value={1}", pItem->getToken(), value);
+    }
+  }
+
+  // Alarms for the item, none for most items
+  for (auto &alarm : pItem->getAlarms()) {
+    if (alarm.check(value)) {
+      alarmToReceiveQueue(alarm);
+    }
+  }
+
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// measurementToReceiveQueue
+//
+
+bool
+CEnergyP1::measurementToReceiveQueue(vscpEventEx &ex, CP1Item *pItem, const CP1Line &line)
+{
+  setEventTime(ex, pItem, line);
+
+  vscpEvent *pEvent = m_eventPool.fromEx(ex);
+  if (nullptr == pEvent) {
+    spdlog::error("Failed to allocate memory for event.");
+    return false;
+  }
+
+  if (!addEvent2ReceiveQueue(pEvent, pItem)) {
+    m_eventPool.release(pEvent);
+    return false;
+  }
+
+  if (spdlog::should_log(spdlog::level::debug)) {
+    spdlog::debug("Event added to receive queue class={0} type={1}", ex.vscp_class, ex.vscp_type);
+  }
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// alarmToReceiveQueue
+//
+
+bool
+CEnergyP1::alarmToReceiveQueue(const CAlarm &alarm)
+{
+  vscpEventEx ex = alarm.getEventEx();
+  setTelegramTime(ex);
+
+  vscpEvent *pEvent = m_eventPool.fromEx(ex);
+  if (nullptr == pEvent) {
+    spdlog::error("Alarm: Failed to allocate memory for event.");
+    return false;
+  }
+
+  if (!addEvent2ReceiveQueue(pEvent)) {
+    m_eventPool.release(pEvent);
+    return false;
+  }
+
+  spdlog::debug("Sent {0} alarm [{1}]", alarm.isReset() ? "OFF" : "ON", alarm.getVariable());
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// eventExToReceiveQueue
+//
+
+bool
+CEnergyP1::eventExToReceiveQueue(vscpEventEx &ex)
+{
+  vscpEvent *pev = m_eventPool.fromEx(ex);
+
+  if (NULL != pev) {
+    if (!vscp_doLevel2Filter(pev, &m_rxfilter) || !addEvent2ReceiveQueue(pev)) {
+      m_eventPool.release(pev);
     }
   }
   else {
@@ -2101,13 +2439,77 @@ CEnergyP1::eventExToReceiveQueue(vscpEventEx &ex)
 bool
 CEnergyP1::addEvent2SendQueue(const vscpEvent *pEvent)
 {
-  pthread_mutex_lock(&m_mutexSendQueue);
-  m_sendList.push_back((vscpEvent *) pEvent);
-  sem_post(&m_semSendQueue);
-  pthread_mutex_unlock(&m_mutexSendQueue);
+  // Only HLO commands are handled
+  if ((VSCP_CLASS2_HLO != pEvent->vscp_class) || (VSCP2_TYPE_HLO_COMMAND != pEvent->vscp_type)) {
+    return true;
+  }
+
+  // The host owns the event, keep a copy
+  vscpEventEx ex;
+  if (!vscp_convertEventToEventEx(&ex, pEvent)) {
+    return false;
+  }
+
+  vscpEvent *pev = m_eventPool.fromExLocked(ex);
+  if (nullptr == pev) {
+    return false;
+  }
+
+  if (!m_sendQueue.push(pev)) {
+    m_eventPool.releaseLocked(pev);
+    return false;
+  }
+
+  wakeupWorker();
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+// setSerialLine
+//
+
+bool
+CEnergyP1::setSerialLine(const std::string &line, bool bOn)
+{
+  if (nullptr == m_pComm) {
+    spdlog::warn("Serial port not open, can't set {}.", line);
+    return false;
+  }
+
+  if (("dtr" == line) && bOn) {
+    m_pComm->DtrOn();
+  }
+  else if ("dtr" == line) {
+    m_pComm->DtrOff();
+  }
+  else if (("rts" == line) && bOn) {
+    m_pComm->RtsOn();
+  }
+  else if ("rts" == line) {
+    m_pComm->RtsOff();
+  }
+  else {
+    return false;
+  }
+
+  spdlog::debug("Serial line {0} {1}", line, bOn ? "on" : "off");
   return true;
 }
 
+//////////////////////////////////////////////////////////////////////
+// doSendQueue
+//
+
+void
+CEnergyP1::doSendQueue(void)
+{
+  vscpEvent *pev;
+  while (nullptr != (pev = m_sendQueue.pop())) {
+    handleHLO(pev);
+    m_eventPool.releaseLocked(pev);
+  }
+}
+
 //////////////////////////////////////////////////////////////////////
 // addEvent2ReceiveQueue
 //
@@ -2115,15 +2517,270 @@ CEnergyP1::addEvent2SendQueue(const vscpEvent *pEvent)
 //
 
 bool
-CEnergyP1::addEvent2ReceiveQueue(const vscpEvent *pEvent)
+CEnergyP1::addEvent2ReceiveQueue(const vscpEvent *pEvent, CP1Item *pItem)
 {
-  pthread_mutex_lock(&m_mutexReceiveQueue);
-  m_receiveList.push_back((vscpEvent *) pEvent);
-  pthread_mutex_unlock(&m_mutexReceiveQueue);
-  sem_post(&m_semReceiveQueue);
+  // Collected while a telegram is handled
+  if (m_bBatch) {
+    m_batch.push_back((vscpEvent *) pEvent);
+    m_batchItems.push_back(pItem);
+    return true;
+  }
+
+  if (m_cntHeldEvents && !m_bQueueLatest) {
+    flushHeldEvents();
+  }
+
+  if (!queueEvent((vscpEvent *) pEvent, pItem)) {
+    return false;
+  }
+
+  signalReceiveQueue();
   return true;
 }
 
+//////////////////////////////////////////////////////////////////////
+// queueEvent
+//
+
+bool
+CEnergyP1::queueEvent(vscpEvent *pEvent, CP1Item *pItem)
+{
+  // Queue mode latest, measurements wait on their item for the host
+  if (m_bQueueLatest && (nullptr != pItem)) {
+    // Counted before it is visible so the reader never counts below zero
+    m_cntHeldEvents++;
+    vscpEvent *pOld = pItem->exchangeHeldEvent(pEvent);
+    if (nullptr != pOld) {
+      // Not read yet, replaced by the new value
+      m_cntHeldEvents--;
+      m_cntQueueReplaced++;
+      m_eventPool.release(pOld);
+    }
+    return true;
+  }
+
+  if (m_receiveQueue.push(pEvent)) {
+    m_bQueueFull = false;
+    return true;
+  }
+
+  if (!m_bQueueFull) {
+    spdlog::warn("Receive queue is full ({} events). Events are dropped.", m_receiveQueue.getLimit());
+    m_bQueueFull = true;
+  }
+
+  m_cntQueueDropped++;
+
+  if (P1_QUEUE_DROP_OLDEST == m_queuePolicy) {
+    vscpEvent *pOldest = m_receiveQueue.pop();
+    if (nullptr != pOldest) {
+      m_eventPool.release(pOldest);
+    }
+    // Only this thread adds events so there is room now
+    return m_receiveQueue.push(pEvent);
+  }
+  else if ((P1_QUEUE_LATEST_PER_ITEM == m_queuePolicy) && (nullptr != pItem)) {
+    // Replace the value not sent yet
+    if (nullptr != pItem->getHeldEvent()) {
+      m_eventPool.release(pItem->getHeldEvent());
+    }
+    else {
+      m_cntHeldEvents++;
+      m_cntQueueDropped--; // Nothing dropped yet
+    }
+    pItem->setHeldEvent(pEvent);
+    return true;
+  }
+
+  // Drop newest, also for events that are not measurements
+  // when latest-per-item is used
+  return false;
+}
+
+//////////////////////////////////////////////////////////////////////
+// flushHeldEvents
+//
+
+size_t
+CEnergyP1::flushHeldEvents(void)
+{
+  size_t cnt = 0;
+
+  for (auto const &pItem : m_listItems) {
+    if (!m_cntHeldEvents) {
+      break;
+    }
+
+    vscpEvent *pev = pItem->getHeldEvent();
+    if (nullptr == pev) {
+      continue;
+    }
+
+    if (!m_receiveQueue.push(pev)) {
+      break; // Still full
+    }
+
+    pItem->setHeldEvent(nullptr);
+    m_cntHeldEvents--;
+    cnt++;
+  }
+
+  return cnt;
+}
+
+//////////////////////////////////////////////////////////////////////
+// takeHeldEvent
+//
+
+vscpEvent *
+CEnergyP1::takeHeldEvent(void)
+{
+  size_t cnt = m_listItems.size();
+
+  // Go on from the item after the last one read so all items
+  // get their turn
+  for (size_t i = 0; i < cnt; i++) {
+    if (m_idxHeldScan >= cnt) {
+      m_idxHeldScan = 0;
+    }
+
+    CP1Item *pItem = m_listItems[m_idxHeldScan++];
+    if (nullptr == pItem->getHeldEvent()) {
+      continue;
+    }
+
+    vscpEvent *pev = pItem->exchangeHeldEvent(nullptr);
+    if (nullptr != pev) {
+      m_cntHeldEvents--;
+      return pev;
+    }
+  }
+
+  return nullptr;
+}
+
+//////////////////////////////////////////////////////////////////////
+// signalReceiveQueue
+//
+
+void
+CEnergyP1::signalReceiveQueue(void)
+{
+  sem_post(&m_semReceiveQueue);
+
+  uint64_t one = 1;
+  if ((-1 != m_fdReceive) && (-1 == ::write(m_fdReceive, &one, sizeof(one)))) {
+    spdlog::warn("Failed to signal receive descriptor.");
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+// publishBatch
+//
+
+void
+CEnergyP1::publishBatch(void)
+{
+  size_t cntQueued = 0;
+
+  // Values held from earlier telegrams go first
+  if (m_cntHeldEvents && !m_bQueueLatest) {
+    cntQueued += flushHeldEvents();
+  }
+
+  if (m_batch.size()) {
+
+    // As many as there is room for in one go. In queue mode latest
+    // measurements go to their items so all events are queued one
+    // by one.
+    size_t cnt = 0;
+    if (!m_bQueueLatest) {
+      cnt = m_receiveQueue.push(m_batch.data(), m_batch.size());
+      if (cnt) {
+        m_bQueueFull = false;
+      }
+      cntQueued += cnt;
+    }
+
+    // The rest according to the queue policy
+    for (size_t i = cnt; i < m_batch.size(); i++) {
+      if (queueEvent(m_batch[i], m_batchItems[i])) {
+        cntQueued++;
+      }
+      else {
+        m_eventPool.release(m_batch[i]);
+      }
+    }
+  }
+
+  // One wakeup for the whole batch
+  if (cntQueued) {
+    signalReceiveQueue();
+  }
+
+  m_batch.clear();
+  m_batchItems.clear();
+}
+
+//////////////////////////////////////////////////////////////////////
+// popReceiveQueue
+//
+
+vscpEvent *
+CEnergyP1::popReceiveQueue(void)
+{
+  vscpEvent *pev = m_receiveQueue.pop();
+
+  // Alarms and replies first, then the newest measurement values
+  if ((nullptr == pev) && m_bQueueLatest && m_cntHeldEvents) {
+    pev = takeHeldEvent();
+  }
+
+  if (isReceiveQueueEmpty()) {
+
+    if (nullptr != pev) {
+      // A post is done per batch, not per event. Take away posts
+      // for events already read so the count stays small. Events
+      // are always queued before the post so a post for an event
+      // that is not read yet can only be taken if the reader
+      // finds the event before it waits.
+      while (0 == sem_trywait(&m_semReceiveQueue)) {
+        ;
+      }
+    }
+
+    // Nothing to read, the descriptor should not be readable
+    uint64_t cnt;
+    if ((-1 != m_fdReceive) && (sizeof(cnt) == ::read(m_fdReceive, &cnt, sizeof(cnt)))) {
+      // Events added after the check above must keep it readable
+      if (!isReceiveQueueEmpty()) {
+        signalReceiveQueue();
+      }
+    }
+  }
+
+  return pev;
+}
+
+//////////////////////////////////////////////////////////////////////
+// popReceiveQueue
+//
+
+size_t
+CEnergyP1::popReceiveQueue(vscpEventEx *pex, size_t max)
+{
+  size_t cnt = 0;
+  vscpEvent *pev;
+
+  while ((cnt < max) && (nullptr != (pev = popReceiveQueue()))) {
+    vscp_convertEventToEventEx(&pex[cnt], pev);
+    m_eventPool.releaseReader(pev);
+    cnt++;
+  }
+
+  return cnt;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // startWorkerThread
 //
@@ -2168,6 +2825,23 @@ CEnergyP1::stopWorkerThread(void)
   return true;
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// wakeupWorker
+//
+
+void
+CEnergyP1::wakeupWorker(void)
+{
+  uint64_t one = 1;
+  if (-1 == m_fdWakeup) {
+    return;
+  }
+
+  if (-1 == ::write(m_fdWakeup, &one, sizeof(one))) {
+    spdlog::warn("Failed to signal worker thread wakeup.");
+  }
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // readEncryptionKey
 //
@@ -2191,6 +2865,71 @@ CEnergyP1::readEncryptionKey(const std::string &path)
 
 // ----------------------------------------------------------------------------
 
+/////////////////////////////////////////////////////////////////////////////
+// openSerialPort
+//
+// Open and set up the serial port. Also used to reopen the port
+// after it has been lost.
+//
+
+static bool
+openSerialPort(CEnergyP1 *pObj, Comm &com)
+{
+  if (!com.open((const char *) pObj->m_serialDevice.c_str())) {
+    return false;
+  }
+
+  // Set serial parameters
+  com.setParam(pObj->m_serialBaudrate.c_str(),
+               pObj->m_serialParity.c_str(),
+               pObj->m_serialCountDataBits.c_str(),
+               pObj->m_bSerialHwFlowCtrl ? 1 : 0,
+               pObj->m_bSerialSwFlowCtrl ? 1 : 0);
+
+  // Set DTR if requested to do so
+  if (pObj->m_bDtrOnStart) {
+    spdlog::debug("Working thread: DTR ON");
+    com.DtrOn();
+  }
+
+  // Control lines can be set with HLO commands
+  pObj->m_pComm = &com;
+
+  // A telegram cut by a lost port is not completed by the next one
+  pObj->m_framer.reset();
+  pObj->m_telegram.reset();
+
+  return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// closeSerialPort
+//
+
+static void
+closeSerialPort(CEnergyP1 *pObj, Comm &com)
+{
+  pObj->m_pComm = nullptr;
+  com.close();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// reopenTimeout
+//
+// Milliseconds for poll to wait until it is time to try to open the
+// serial port at reopenAt, zero if that time has passed
+//
+
+static int
+reopenTimeout(const struct timespec &reopenAt)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  int64_t ms = (int64_t) (reopenAt.tv_sec - now.tv_sec) * 1000 + (reopenAt.tv_nsec - now.tv_nsec) / 1000000;
+  return (ms > 0) ? (int) ms : 0;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // workerThread
 //
@@ -2198,14 +2937,6 @@ CEnergyP1::readEncryptionKey(const std::string &path)
 void *
 workerThread(void *pData)
 {
-  char buf[1024];
-  std::string strbuf;
-  uint16_t pos = 0;
-
-  // Change locale to get the correct decimal point "."
-  std::setlocale(LC_NUMERIC, "C");
-  // setlocale(LC_NUMERIC, "");
-
   // Linux serial port
   Comm com;
 
@@ -2216,58 +2947,143 @@ workerThread(void *pData)
 
   spdlog::debug("Working thread: Starting Worker loop GUID = {}", pObj->m_guid.getAsString());
 
+  // Wait for serial data or a wakeup request. Nothing runs between
+  // telegrams, the thread sleeps in poll until something arrives.
+  // While the serial port is closed its fd is negative, poll skips
+  // it and times out when it is time to try to open it again. Host
+  // events are handled also while the port is closed.
+  struct pollfd fds[2];
+  fds[0].fd     = -1;
+  fds[0].events = POLLIN;
+  fds[1].fd     = pObj->m_fdWakeup;
+  fds[1].events = POLLIN;
+
+  // Seconds to wait before the next try to open the port and the
+  // time for that try
+  int reopenTime = VSCP_ENERGYP1_MIN_REOPEN_TIME;
+  struct timespec reopenAt = { 0, 0 };
+
   // Open the serial port
-  if (!com.open((const char *) pObj->m_serialDevice.c_str())) {
-    spdlog::debug("Working thread: Failed to open serial port");
-    return NULL;
+  if (openSerialPort(pObj, com)) {
+    fds[0].fd = com.getFD();
   }
-
-  // Set serial parameters
-  com.setParam(pObj->m_serialBaudrate.c_str(),
-               pObj->m_serialParity.c_str(),
-               pObj->m_serialCountDataBits.c_str(),
-               pObj->m_bSerialHwFlowCtrl ? 1 : 0,
-               pObj->m_bSerialSwFlowCtrl ? 1 : 0);
-
-  // Set DTR if requested to do so
-  if (pObj->m_bDtrOnStart) {
-    spdlog::debug("Working thread: DTR ON");
-    com.DtrOn();
+  else {
+    spdlog::error("Working thread: Failed to open serial port {}. Retry in {} s",
+                  pObj->m_serialDevice,
+                  reopenTime);
+    clock_gettime(CLOCK_MONOTONIC, &reopenAt);
+    reopenAt.tv_sec += reopenTime;
   }
 
   // Work on
   while (!pObj->m_bQuit) {
 
-    pos  = 0;
-    *buf = 0;
-
-    if (com.isCharReady()) {
-      int read;
-      while (com.isCharReady()) {
-        char c = com.readChar(&read);
-        if (read) {
-          buf[pos++] = c;
-          if (pos > sizeof(buf) - 1) {
-            spdlog::debug("Working thread: Serial Buffer overflow");
-            continue;
-          }
-          // Check for EOL
-          if (0x0a == c) {
-            buf[pos] = 0;   // Add terminating zero
-            strbuf   = buf; // Add to the string buffer
-            spdlog::trace("strbuf = {0}\n", strbuf.c_str());
-            pObj->doWork(strbuf); // Do work
-            break;
-          }
-        }
-      } // while
+    fds[0].revents = 0;
+    fds[1].revents = 0;
+
+    int rv = poll(fds, 2, (-1 == fds[0].fd) ? reopenTimeout(reopenAt) : -1);
+    if (-1 == rv) {
+      if (EINTR == errno) {
+        continue;
+      }
+      spdlog::error("Working thread: poll failed errno={}", errno);
+      break;
     }
-    else {
-      // If no data we sleep for a second  - no rush here...
-      sleep(1);
+
+    // Time to try to open a lost port again
+    if ((0 == rv) && (-1 == fds[0].fd)) {
+      if (openSerialPort(pObj, com)) {
+        spdlog::info("Working thread: Serial port {} open", pObj->m_serialDevice);
+        fds[0].fd  = com.getFD();
+        reopenTime = VSCP_ENERGYP1_MIN_REOPEN_TIME;
+      }
+      else {
+        // Back off up to the reconnect time
+        reopenTime = std::min(2 * reopenTime, VSCP_ENERGYP1_DEFAULT_RECONNECT_TIME);
+        spdlog::debug("Working thread: Failed to open serial port. Retry in {} s", reopenTime);
+        clock_gettime(CLOCK_MONOTONIC, &reopenAt);
+        reopenAt.tv_sec += reopenTime;
+      }
       continue;
     }
 
+    // Asked to terminate or events from the host
+    if (fds[1].revents & POLLIN) {
+      uint64_t cnt;
+      if (-1 == ::read(pObj->m_fdWakeup, &cnt, sizeof(cnt))) {
+        spdlog::trace("Working thread: Wakeup already cleared");
+      }
+
+      if (pObj->m_bQuit) {
+        break;
+      }
+
+      pObj->doSendQueue();
+    }
+
+    // Lost port (USB adapter unplugged etc), close it and open it again
+    // later. Host events are still handled meanwhile.
+    if (fds[0].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+      spdlog::error("Working thread: Serial port error/hangup revents={}. Retry in {} s",
+                    fds[0].revents,
+                    reopenTime);
+      closeSerialPort(pObj, com);
+      fds[0].fd = -1;
+      clock_gettime(CLOCK_MONOTONIC, &reopenAt);
+      reopenAt.tv_sec += reopenTime;
+      continue;
+    }
+
+    if (fds[0].revents & POLLIN) {
+
+      // Get everything that is available in one read
+      if (-1 == pObj->m_framer.readFrom(com.getFD())) {
+        if ((EAGAIN != errno) && (EINTR != errno)) {
+          spdlog::error("Working thread: Serial read failed errno={}. Retry in {} s", errno, reopenTime);
+          closeSerialPort(pObj, com);
+          fds[0].fd = -1;
+          clock_gettime(CLOCK_MONOTONIC, &reopenAt);
+          reopenAt.tv_sec += reopenTime;
+        }
+        continue;
+      }
+
+      // Handle all full lines read so far
+      const char *pline;
+      size_t len;
+      uint64_t cntOverruns = pObj->m_framer.getOverrunCount();
+      while (pObj->m_framer.getLine(&pline, &len)) {
+        if (spdlog::should_log(spdlog::level::trace)) {
+          spdlog::trace("line = {0}", spdlog::string_view_t(pline, len));
+        }
+        switch (pObj->m_telegram.addLine(pline, len)) {
+
+          case P1_TELEGRAM_COMPLETE:
+            pObj->doTelegram(pObj->m_telegram); // Do work
+            break;
+
+          case P1_TELEGRAM_CRC_ERROR:
+            spdlog::warn("Working thread: Telegram CRC error, telegram dropped. Total errors={0}",
+                         pObj->m_telegram.getCrcErrorCount());
+            break;
+
+          case P1_TELEGRAM_OVERFLOW:
+            spdlog::warn("Working thread: Telegram too large, telegram dropped. Total overflows={0}",
+                         pObj->m_telegram.getOverflowCount());
+            break;
+
+          default:
+            break;
+        }
+      }
+
+      if (cntOverruns != pObj->m_framer.getOverrunCount()) {
+        spdlog::debug("Working thread: Serial line overrun. Total overruns={0} bytes={1}",
+                      pObj->m_framer.getOverrunCount(),
+                      pObj->m_framer.getOverrunBytes());
+      }
+    }
+
     // dowork:
 
     //   buf[pos] = 0;   // Add terminating zero
@@ -2609,15 +3425,18 @@ workerThread(void *pData)
 
   } // Main loop
 
-  // Set DTR if requested to do so
-  if (pObj->m_bDtrOnStart) {
-    spdlog::debug("Working thread: DTR OFF");
-    com.DtrOff();
-  }
+  if (-1 != fds[0].fd) {
 
-  // Close the serial port
-  spdlog::debug("Working thread: Closing serial port");
-  com.close();
+    // Set DTR if requested to do so
+    if (pObj->m_bDtrOnStart) {
+      spdlog::debug("Working thread: DTR OFF");
+      com.DtrOff();
+    }
+
+    // Close the serial port
+    spdlog::debug("Working thread: Closing serial port");
+    closeSerialPort(pObj, com);
+  }
 
   spdlog::debug("Working thread: Ending Worker loop");
 
@@ -30,8 +30,10 @@
 #include "StdAfx.h"
 #endif
 
+#include <atomic>
 #include <list>
 #include <string>
+#include <vector>
 
 #include <pthread.h>
 #include <stdio.h>
@@ -50,7 +52,12 @@
 #include <vscp.h>
 
 #include "alarm.h"
+#include "eventpool.h"
+#include "eventqueue.h"
+#include "obis.h"
 #include "p1item.h"
+#include "p1framer.h"
+#include "p1telegram.h"
 
 #include <nlohmann/json.hpp>  // Needs C++11  -std=c++11
 
@@ -62,11 +69,23 @@ using json = nlohmann::json;
 
 const uint16_t MAX_ITEMS_IN_QUEUE = 32000;
 
+// Max number of events from the host waiting for the worker thread
+const uint16_t MAX_ITEMS_IN_SEND_QUEUE = 256;
+
+// What is dropped when the receive queue is full ("queue-policy")
+#define P1_QUEUE_DROP_OLDEST      0 // Oldest event in the queue (default)
+#define P1_QUEUE_DROP_NEWEST      1 // The new event
+#define P1_QUEUE_LATEST_PER_ITEM  2 // Newest value per item held until there is room
+
 #define DRIVER_COPYRIGHT "Copyright © 2000-2024 Ake Hedman, the VSCP Project, https://www.vscp.org"
 
 // Seconds before trying to reconnect to a broken connection
 #define VSCP_ENERGYP1_DEFAULT_RECONNECT_TIME 30
 
+// Seconds before the first try to reopen a lost serial port. Doubled
+// for each failed try up to VSCP_ENERGYP1_DEFAULT_RECONNECT_TIME
+#define VSCP_ENERGYP1_MIN_REOPEN_TIME 1
+
 #define VSCP_ENERGYP1_SYSLOG_DRIVER_ID "[vscpl2drv-energyp1] "
 #define VSCP_LEVEL2_DLL_LOGGER_OBJ_MUTEX                                       \
     "___VSCP__DLL_L2TCPIPLINK_OBJ_MUTEX____"
@@ -78,6 +97,7 @@ const uint16_t MAX_ITEMS_IN_QUEUE = 32000;
 
 // Forward declarations
 class CHLO;
+class Comm;
 
 class CEnergyP1
 {
@@ -123,6 +143,14 @@ class CEnergyP1
 
     bool readVariable(vscpEventEx& ex, const json& json_req);
 
+    /*!
+      Put a JSON reply in the data of an HLO response event. A reply
+      that does not fit is replaced with an error reply.
+      @param ex Response event
+      @param j Reply
+    */
+    void setReply(vscpEventEx& ex, const json& j);
+
     bool writeVariable(vscpEventEx& ex, const json& json_req);
 
     bool deleteVariable(vscpEventEx& ex, const json& json_req);
@@ -147,14 +175,84 @@ class CEnergyP1
     bool eventExToReceiveQueue(vscpEventEx& ex);
 
     /*!
-      Add event to send queue
+      Add event to send queue. The event is copied and handled by the
+      worker thread, this never waits. Events the driver does not
+      handle are ignored.
+      @param pEvent Event from the host
+      @return true on success, false if the queue is full.
      */
     bool addEvent2SendQueue(const vscpEvent* pEvent);
 
     /*!
-      Add event to receive queue
+      Handle all events on the send queue (worker thread)
+    */
+    void doSendQueue(void);
+
+    /*!
+      Set a serial port control line (worker thread)
+      @param line "dtr" or "rts"
+      @param bOn true to set the line on
+      @return true on success
+    */
+    bool setSerialLine(const std::string& line, bool bOn);
+
+    /*!
+      Add event to receive queue. While a telegram is handled the
+      event is held back and put on the queue with the rest of the
+      events from the telegram by publishBatch.
+    */
+    bool addEvent2ReceiveQueue(const vscpEvent* pEvent, CP1Item* pItem = nullptr);
+
+    /*!
+      Put an event on the receive queue using the queue policy if the
+      queue is full. The reader is not signalled.
+      @param pEvent Event to add
+      @param pItem Item the event is a measurement for or nullptr
+      @return true if the event was queued or held for its item,
+              false if it was dropped and should be given back to
+              the pool by the caller.
+    */
+    bool queueEvent(vscpEvent* pEvent, CP1Item* pItem);
+
+    /*!
+      Move events held for items (queue policy latest-per-item) to the
+      receive queue as long as there is room.
+      @return Number of events moved
+    */
+    size_t flushHeldEvents(void);
+
+    /*!
+      Take the newest value of the next item that has one waiting
+      (queue mode latest). Called by the reader only.
+      @return Event or nullptr if no item has a value waiting.
+    */
+    vscpEvent* takeHeldEvent(void);
+
+    /*!
+      Put all held back events on the receive queue at once and
+      signal the reader once. Events that do not fit are dropped.
     */
-    bool addEvent2ReceiveQueue(const vscpEvent* pEvent);
+    void publishBatch(void);
+
+    /*!
+      Take the first event from the receive queue without waiting.
+      In queue mode latest the newest values of the items are taken
+      when the queue is empty. The semaphore is posted once per
+      batch, so always try this before waiting on m_semReceiveQueue.
+      @return Event or nullptr if the queue is empty. The event
+              should be given back with m_eventPool.releaseReader.
+    */
+    vscpEvent* popReceiveQueue(void);
+
+    /*!
+      Take up to max events from the receive queue without waiting
+      and copy them to an array. The events are given back to the
+      pool. Nothing is allocated.
+      @param pex Array for events
+      @param max Number of events the array can hold
+      @return Number of events copied to the array
+    */
+    size_t popReceiveQueue(vscpEventEx* pex, size_t max);
 
     // Send event to host
     bool sendEvent(vscpEvent *pEvent);
@@ -168,10 +266,88 @@ class CEnergyP1
 
     /*!
       Parse and send measurement events
-      @param strbuf String row to handel
+      @param pbuf Pointer to line to handle
+      @param len Length of line
       @return true on success, false on frailure
     */
-    bool doWork(std::string& strbuf);
+    bool doWork(const char* pbuf, size_t len);
+
+    /*!
+      Send measurement events for all items that match a line
+      @param line Parsed line
+      @return true on success, false on failure
+    */
+    bool doLine(const CP1Line& line);
+
+    /*!
+      Handle all data lines of a complete and checked telegram
+      @param telegram Telegram to handle
+      @return true on success, false on failure
+    */
+    bool doTelegram(const CP1Telegram& telegram);
+
+    /*!
+      Send measurement event and check alarms for one item
+      @param pItem Item that matched the line
+      @param line Line to handle
+      @return true on success, false on failure
+    */
+    bool doItem(CP1Item* pItem, const CP1Line& line);
+
+    /*!
+      Set time of a measurement event and put it on the receive
+      queue
+      @param ex Event with all but time set
+      @param pItem Item the event is for
+      @param line Line the value is from
+      @return true on success, false on failure
+    */
+    bool measurementToReceiveQueue(vscpEventEx& ex, CP1Item* pItem, const CP1Line& line);
+
+    /*!
+      Send the prebuilt event of an alarm with the telegram time
+      @param alarm Alarm to send
+      @return true on success
+    */
+    bool alarmToReceiveQueue(const CAlarm& alarm);
+
+    /*!
+      Set timestamp and date/time of a measurement event. The date
+      and time is taken from the time group of the line if the item
+      has one, otherwise current time is used.
+      @param ex Event to set time for
+      @param pItem Item the event is for
+      @param line Line the value is from
+    */
+    void setEventTime(vscpEventEx& ex, CP1Item* pItem, const CP1Line& line);
+
+    /*!
+      Set timestamp and date/time of an event to the time of the
+      telegram being handled.
+      @param ex Event to set time for
+    */
+    void setTelegramTime(vscpEventEx& ex);
+
+    /*!
+      Read the clock once and set the time used for all events from
+      a telegram. The telegram time stamp (0-0:1.0.0) is used if
+      found and meter time is enabled. The difference between host
+      clock and meter clock is saved as a diagnostic.
+      @param ptelegram Telegram or nullptr to use host time.
+    */
+    void updateTelegramTime(const CP1Telegram* ptelegram);
+
+    /*!
+      Add the built in DSMR items (dsmr-items.h) to the item list.
+      @return true on success
+    */
+    bool loadBuiltinItems(void);
+
+    /*!
+      Build the OBIS code lookup and the event templates for the
+      configured items. Called when items have been loaded.
+    */
+    void buildItemIndex(void);
 
   public:
 
@@ -235,6 +411,37 @@ class CEnergyP1
     */
     bool m_bDtrOnStart;
 
+    /*!
+      Offset from UTC in minutes for timestamps from the meter
+      (standard time, one hour is added for daylight saving time).
+    */
+    int m_meterUtcOffset;
+
+    /*!
+      True to use the telegram time stamp from the meter as time for
+      events. If false host time is used.
+    */
+    bool m_bMeterTime;
+
+    /*!
+      Host clock minus meter clock in seconds, from last telegram
+      with a time stamp.
+    */
+    int64_t m_clockSkew;
+
+    /// True when m_clockSkew holds a measured value
+    bool m_bClockSkewValid;
+
+    /*!
+      Event timestamp (microseconds) for the telegram being handled
+    */
+    uint32_t m_telegramTimestamp;
+
+    /*!
+      Date/time (UTC) for the telegram being handled
+    */
+    p1_datetime m_telegramTime;
+
 
     /////////////////////////////////////////////////////////
     //                      Logging
@@ -277,51 +484,147 @@ class CEnergyP1
     std::deque<CP1Item *> m_listItems;
 
     /*!
-      Map with last measurement value
+      OBIS code to item lookup for all items that have an OBIS
+      code as token.
     */
-   std::map<std::string, double> m_lastValue;
+    CObisMap m_obisMap;
 
-   /*!
-      Map with set alarm definitions
+    /*!
+      Items with a token that is not an OBIS code. These are
+      matched against the start of each line.
     */
-   std::map<std::string, CAlarm *> m_mapAlarmOn;
+    std::vector<CP1Item *> m_listPrefixItems;
 
    /*!
-      Map with reset alarm definitions
+      Alarms from the configuration. Copied to the items with the
+      variable they test when the item index is built.
     */
-   std::map<std::string, CAlarm *> m_mapAlarmOff;
+   std::vector<CAlarm> m_listAlarms;
  
     // ------------------------------------------------------------------------
 
-    /// Send queue (Send to device)
-    std::list<vscpEvent*> m_sendList;
+    /*!
+      Send queue (events from the host). Written by the host with
+      VSCPWrite, read by the worker thread.
+    */
+    CEventQueueMP m_sendQueue;
 
-    /// Receive queue (Send event to host)
-    std::list<vscpEvent*> m_receiveList;
+    /*!
+      Receive queue (Send event to host). Lock free with the worker
+      thread as the only writer and the host reading with VSCPRead.
+      Events that do not fit are dropped.
+    */
+    CEventQueue m_receiveQueue;
 
-    // Maximum number of events in the outgoing queue
-    uint16_t m_maxItemsInClientReceiveQueue;
+    /// True while the events of a telegram are collected
+    bool m_bBatch;
+
+    /// Events held back until the telegram has been handled
+    std::vector<vscpEvent*> m_batch;
+
+    /// Item for each event in m_batch (nullptr if not a measurement)
+    std::vector<CP1Item*> m_batchItems;
+
+    /// P1_QUEUE_xxx policy used when the receive queue is full
+    int m_queuePolicy;
 
     /*!
-        Event object to indicate that there is an event in the output queue
-     */
-    sem_t m_semSendQueue;
+      Queue mode latest ("queue-mode"). Measurements are not put on
+      the receive queue but wait on their item where a new value
+      replaces the one not read yet. Alarms and replies are still
+      put on the receive queue and are read first.
+    */
+    bool m_bQueueLatest;
+
+    /// Number of items with an event held (never less than the real number)
+    std::atomic<size_t> m_cntHeldEvents;
+
+    /// Next item to look at in takeHeldEvent
+    size_t m_idxHeldScan;
+
+    /// Number of values replaced before the host read them (queue mode latest)
+    uint64_t m_cntQueueReplaced;
+
+    /// True when the receive queue was full last time an event was added
+    bool m_bQueueFull;
+
+    /// Number of events dropped because the receive queue was full
+    uint64_t m_cntQueueDropped;
 
     /*!
-      Event object to indicate that there is an event in the input queue
+      Events for the receive queue are taken from this pool and
+      given back to it when the host has read them.
     */
-    sem_t m_semReceiveQueue;
+    CEventPool m_eventPool;
 
-    /// Mutex to protect the output queue
-    pthread_mutex_t m_mutexSendQueue;
+    // Maximum number of events in the outgoing queue ("max-in-queue")
+    uint16_t m_maxItemsInClientReceiveQueue;
 
-    /// Mutex to protet the input queue
-    pthread_mutex_t m_mutexReceiveQueue;
+    /*!
+      Event object to indicate that there is an event in the input queue
+    */
+    sem_t m_semReceiveQueue;
 
     /*!
       Serial worker thread
     */
     pthread_t m_workerThread;
+
+    /*!
+      Serial input line framer. Filled with one read per poll wakeup,
+      lines are split out of it by the worker thread. Partial lines
+      are kept between reads.
+    */
+    CP1Framer m_framer;
+
+    /*!
+      Lines of the telegram being received. Items are handled only
+      when the full telegram is in and the CRC is OK.
+    */
+    CP1Telegram m_telegram;
+
+    /*!
+      Wakeup descriptor (eventfd) for the worker thread. The worker
+      blocks in poll on the serial port and this descriptor. Writing
+      to it makes the worker leave poll at once to quit or to handle
+      events on the send queue.
+    */
+    int m_fdWakeup;
+
+    /*!
+      Serial port while the worker thread has it open, else nullptr.
+      Only used by the worker thread.
+    */
+    Comm* m_pComm;
+
+    /*!
+      Wake up the worker thread if it is blocked waiting for
+      serial data.
+    */
+    void wakeupWorker(void);
+
+    /*!
+      Receive descriptor (eventfd). Readable as long as there are
+      events for the host to read so a host can wait for events from
+      many drivers in one poll/epoll loop and then read without
+      blocking. Only the driver reads from it.
+    */
+    int m_fdReceive;
+
+    /*!
+      Tell the reader that there are events on the receive queue
+      (semaphore and receive descriptor)
+    */
+    void signalReceiveQueue(void);
+
+    /*!
+      Check if there are events for the host
+      @return true if nothing to read.
+    */
+    bool isReceiveQueueEmpty(void) const
+    {
+      return (m_receiveQueue.isEmpty() && !(m_bQueueLatest && m_cntHeldEvents));
+    };
 };
 
 #endif  // !defined(VSCPENERGYP1_H__202105112227__INCLUDED_)
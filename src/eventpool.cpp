@@ -0,0 +1,241 @@
+// eventpool.cpp
+//
+// This file is part of the VSCP (https://www.vscp.org)
+//
+// The MIT License (MIT)
+//
+// Copyright © 2000-2024 Ake Hedman, the VSCP Project
+// <akhe@vscp.org>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+
+#include <new>
+
+#include "eventpool.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// CTOR
+//
+
+CEventPool::CEventPool(size_t blockSize, size_t returnSize)
+  : m_returnQueue(returnSize)
+{
+  m_blockSize   = blockSize ? blockSize : 1;
+  m_pfree       = nullptr;
+  m_pfreeLocked = nullptr;
+  m_cntSlots.store(0);
+  pthread_mutex_init(&m_mutex, NULL);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// DTOR
+//
+
+CEventPool::~CEventPool()
+{
+  for (auto const &pblock : m_blocks) {
+    delete[] pblock;
+  }
+  m_blocks.clear();
+  pthread_mutex_destroy(&m_mutex);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// grow
+//
+
+bool
+CEventPool::grow(slot **ppfree)
+{
+  slot *pblock = new (std::nothrow) slot[m_blockSize];
+  if (nullptr == pblock) {
+    return false;
+  }
+
+  m_blocks.push_back(pblock);
+
+  for (size_t i = 0; i < m_blockSize; i++) {
+    pblock[i].pnext = *ppfree;
+    *ppfree         = &pblock[i];
+  }
+
+  m_cntSlots.fetch_add(m_blockSize, std::memory_order_relaxed);
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// copyEx
+//
+
+void
+CEventPool::copyEx(vscpEvent *pev, const vscpEventEx &ex)
+{
+  pev->crc        = ex.crc;
+  pev->obid       = ex.obid;
+  pev->timestamp  = ex.timestamp;
+  pev->year       = ex.year;
+  pev->month      = ex.month;
+  pev->day        = ex.day;
+  pev->hour       = ex.hour;
+  pev->minute     = ex.minute;
+  pev->second     = ex.second;
+  pev->head       = ex.head;
+  pev->vscp_class = ex.vscp_class;
+  pev->vscp_type  = ex.vscp_type;
+  memcpy(pev->GUID, ex.GUID, 16);
+
+  pev->sizeData = (ex.sizeData > VSCP_MAX_DATA) ? VSCP_MAX_DATA : ex.sizeData;
+  memcpy(pev->pdata, ex.data, pev->sizeData);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// alloc
+//
+
+vscpEvent *
+CEventPool::alloc(void)
+{
+  if (nullptr == m_pfree) {
+
+    // Slots the reader has given back
+    vscpEvent *pev;
+    while (nullptr != (pev = m_returnQueue.pop())) {
+      slot *pslot  = reinterpret_cast<slot *>(pev);
+      pslot->pnext = m_pfree;
+      m_pfree      = pslot;
+    }
+
+    // Else the slots of the other threads or a new block
+    if (nullptr == m_pfree) {
+      pthread_mutex_lock(&m_mutex);
+      if (nullptr != m_pfreeLocked) {
+        m_pfree       = m_pfreeLocked;
+        m_pfreeLocked = nullptr;
+      }
+      else if (!grow(&m_pfree)) {
+        pthread_mutex_unlock(&m_mutex);
+        return nullptr;
+      }
+      pthread_mutex_unlock(&m_mutex);
+    }
+  }
+
+  slot *pslot = m_pfree;
+  m_pfree     = pslot->pnext;
+
+  memset(&pslot->ev, 0, sizeof(vscpEvent));
+  pslot->ev.pdata = pslot->data;
+  return &pslot->ev;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// fromEx
+//
+
+vscpEvent *
+CEventPool::fromEx(const vscpEventEx &ex)
+{
+  vscpEvent *pev = alloc();
+  if (nullptr == pev) {
+    return nullptr;
+  }
+
+  copyEx(pev, ex);
+  return pev;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// release
+//
+
+void
+CEventPool::release(vscpEvent *pev)
+{
+  if (nullptr == pev) {
+    return;
+  }
+
+  slot *pslot  = reinterpret_cast<slot *>(pev);
+  pslot->pnext = m_pfree;
+  m_pfree      = pslot;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// releaseReader
+//
+
+void
+CEventPool::releaseReader(vscpEvent *pev)
+{
+  if (nullptr == pev) {
+    return;
+  }
+
+  // The worker has not taken the slots given back so far
+  if (!m_returnQueue.push(pev)) {
+    releaseLocked(pev);
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// fromExLocked
+//
+
+vscpEvent *
+CEventPool::fromExLocked(const vscpEventEx &ex)
+{
+  pthread_mutex_lock(&m_mutex);
+
+  if ((nullptr == m_pfreeLocked) && !grow(&m_pfreeLocked)) {
+    pthread_mutex_unlock(&m_mutex);
+    return nullptr;
+  }
+
+  slot *pslot   = m_pfreeLocked;
+  m_pfreeLocked = pslot->pnext;
+
+  pthread_mutex_unlock(&m_mutex);
+
+  memset(&pslot->ev, 0, sizeof(vscpEvent));
+  pslot->ev.pdata = pslot->data;
+  copyEx(&pslot->ev, ex);
+  return &pslot->ev;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// releaseLocked
+//
+
+void
+CEventPool::releaseLocked(vscpEvent *pev)
+{
+  if (nullptr == pev) {
+    return;
+  }
+
+  slot *pslot = reinterpret_cast<slot *>(pev);
+
+  pthread_mutex_lock(&m_mutex);
+  pslot->pnext  = m_pfreeLocked;
+  m_pfreeLocked = pslot;
+  pthread_mutex_unlock(&m_mutex);
+}
@@ -0,0 +1,171 @@
+// eventpool.h
+//
+// This file is part of the VSCP (https://www.vscp.org)
+//
+// The MIT License (MIT)
+//
+// Copyright © 2000-2024 Ake Hedman, the VSCP Project
+// <akhe@vscp.org>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#if !defined(VSCP_EVENTPOOL_H__INCLUDED_)
+#define VSCP_EVENTPOOL_H__INCLUDED_
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <vector>
+
+#include <vscp.h>
+
+#include "eventqueue.h"
+
+/*!
+  Recycling pool of events for the receive path.
+
+  Each slot is a vscpEvent with room for VSCP_MAX_DATA bytes of data
+  right after it, pdata always points into the slot. Slots are
+  allocated in blocks when the pool runs dry and are then reused
+  for the lifetime of the pool, so in steady state no event or event
+  data is allocated from the heap.
+
+  The worker thread owns the free list and takes and gives back
+  slots without any lock. The thread that reads events (VSCPRead)
+  gives slots back through a lock free ring that the worker empties
+  into its free list when it runs dry. Other threads (VSCPWrite) use
+  the Locked methods that work on a second free list protected by a
+  mutex. The mutex is also taken when the pool grows.
+*/
+
+class CEventPool {
+
+public:
+  /*!
+    CTOR
+    @param blockSize Number of slots to allocate each time the pool
+                     needs to grow.
+    @param returnSize Number of slots the reader can give back
+                      before the worker takes them.
+  */
+  CEventPool(size_t blockSize = 64, size_t returnSize = 1024);
+
+  /// DTOR
+  ~CEventPool();
+
+  /*!
+    Get a free event (worker thread only). pdata points to
+    VSCP_MAX_DATA bytes that belong to the event.
+    @return Pointer to event or nullptr if out of memory.
+  */
+  vscpEvent *alloc(void);
+
+  /*!
+    Get a free event and fill it in from an ex event (worker
+    thread only)
+    @param ex Event to copy
+    @return Pointer to event or nullptr if out of memory.
+  */
+  vscpEvent *fromEx(const vscpEventEx &ex);
+
+  /*!
+    Give an event back to the pool (worker thread only)
+    @param pev Event from the pool. nullptr is ignored.
+  */
+  void release(vscpEvent *pev);
+
+  /*!
+    Give an event back to the pool from the thread that reads the
+    receive queue (one thread only)
+    @param pev Event from the pool. nullptr is ignored.
+  */
+  void releaseReader(vscpEvent *pev);
+
+  /*!
+    Get a free event and fill it in from an ex event (any thread)
+    @param ex Event to copy
+    @return Pointer to event or nullptr if out of memory.
+  */
+  vscpEvent *fromExLocked(const vscpEventEx &ex);
+
+  /*!
+    Give an event back to the pool (any thread)
+    @param pev Event from the pool. nullptr is ignored.
+  */
+  void releaseLocked(vscpEvent *pev);
+
+  /// Total number of slots allocated
+  size_t getSlotCount(void) const { return m_cntSlots.load(std::memory_order_relaxed); };
+
+private:
+  // Disable copy
+  CEventPool(const CEventPool &);
+  CEventPool &operator=(const CEventPool &);
+
+  /*!
+    One event with its data. The event must be first so a
+    vscpEvent pointer can be turned back into a slot.
+  */
+  struct slot {
+    vscpEvent ev;
+    uint8_t data[VSCP_MAX_DATA];
+    slot *pnext;
+  };
+
+  /*!
+    Add a block of slots to a free list. Called with the mutex
+    locked.
+    @param ppfree Free list to add the slots to
+    @return true on success, false if out of memory.
+  */
+  bool grow(slot **ppfree);
+
+  /*!
+    Fill in an event from an ex event
+    @param pev Event to fill in
+    @param ex Event to copy
+  */
+  static void copyEx(vscpEvent *pev, const vscpEventEx &ex);
+
+  /// Slots to allocate when growing
+  size_t m_blockSize;
+
+  /// Allocated blocks, freed in the destructor
+  std::vector<slot *> m_blocks;
+
+  /// First free slot of the worker
+  slot *m_pfree;
+
+  /// Slots given back by the reader, taken by the worker
+  CEventQueue m_returnQueue;
+
+  /// First free slot for other threads, protected by m_mutex
+  slot *m_pfreeLocked;
+
+  // Statistics
+  std::atomic<size_t> m_cntSlots;
+
+  /// Protects m_pfreeLocked, m_blocks and growing
+  pthread_mutex_t m_mutex;
+};
+
+#endif // VSCP_EVENTPOOL_H__INCLUDED_
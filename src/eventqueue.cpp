@@ -0,0 +1,232 @@
+// eventqueue.cpp
+//
+// This file is part of the VSCP (https://www.vscp.org)
+//
+// The MIT License (MIT)
+//
+// Copyright © 2000-2024 Ake Hedman, the VSCP Project
+// <akhe@vscp.org>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "eventqueue.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// CTOR
+//
+
+CEventQueue::CEventQueue(size_t size)
+{
+  size_t sz = 2;
+  while (sz < size) {
+    sz <<= 1;
+  }
+
+  m_pslots = new std::atomic<vscpEvent *>[sz];
+  m_mask   = sz - 1;
+  m_limit  = size ? size : 1;
+  m_head.store(0);
+  m_tail.store(0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// DTOR
+//
+
+CEventQueue::~CEventQueue()
+{
+  delete[] m_pslots;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// setLimit
+//
+
+void
+CEventQueue::setLimit(size_t limit)
+{
+  if (limit < 1) {
+    limit = 1;
+  }
+
+  if (limit > (m_mask + 1)) {
+    limit = m_mask + 1;
+  }
+
+  m_limit = limit;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// push
+//
+
+bool
+CEventQueue::push(vscpEvent *pev)
+{
+  size_t head = m_head.load(std::memory_order_relaxed);
+  if ((head - m_tail.load(std::memory_order_acquire)) >= m_limit) {
+    return false;
+  }
+
+  m_pslots[head & m_mask].store(pev, std::memory_order_relaxed);
+  m_head.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// push
+//
+
+size_t
+CEventQueue::push(vscpEvent *const *ppev, size_t cnt)
+{
+  size_t head = m_head.load(std::memory_order_relaxed);
+  size_t used = head - m_tail.load(std::memory_order_acquire);
+  if (used >= m_limit) {
+    return 0;
+  }
+
+  if (cnt > (m_limit - used)) {
+    cnt = m_limit - used;
+  }
+
+  for (size_t i = 0; i < cnt; i++) {
+    m_pslots[(head + i) & m_mask].store(ppev[i], std::memory_order_relaxed);
+  }
+
+  // One store makes all of them visible
+  m_head.store(head + cnt, std::memory_order_release);
+  return cnt;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// pop
+//
+
+vscpEvent *
+CEventQueue::pop(void)
+{
+  size_t tail = m_tail.load(std::memory_order_acquire);
+
+  while (true) {
+    if (tail == m_head.load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+
+    // The slot can only be written again after tail has moved past
+    // it, if someone else took it the swap fails and we try again
+    vscpEvent *pev = m_pslots[tail & m_mask].load(std::memory_order_relaxed);
+    if (m_tail.compare_exchange_weak(tail,
+                                     tail + 1,
+                                     std::memory_order_acq_rel,
+                                     std::memory_order_acquire)) {
+      return pev;
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// CTOR
+//
+
+CEventQueueMP::CEventQueueMP(size_t size)
+{
+  size_t sz = 2;
+  while (sz < size) {
+    sz <<= 1;
+  }
+
+  m_pslots = new slot[sz];
+  m_mask   = sz - 1;
+  for (size_t i = 0; i < sz; i++) {
+    m_pslots[i].seq.store(i);
+    m_pslots[i].pev = nullptr;
+  }
+
+  m_head.store(0);
+  m_tail.store(0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// DTOR
+//
+
+CEventQueueMP::~CEventQueueMP()
+{
+  delete[] m_pslots;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// push
+//
+
+bool
+CEventQueueMP::push(vscpEvent *pev)
+{
+  slot *ps;
+  size_t head = m_head.load(std::memory_order_relaxed);
+
+  while (true) {
+    ps         = &m_pslots[head & m_mask];
+    size_t seq = ps->seq.load(std::memory_order_acquire);
+
+    if (seq == head) {
+      // Free, try to get it
+      if (m_head.compare_exchange_weak(head, head + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    }
+    else if ((intptr_t) (seq - head) < 0) {
+      // Not read yet since last lap, full
+      return false;
+    }
+    else {
+      // Taken by another producer
+      head = m_head.load(std::memory_order_relaxed);
+    }
+  }
+
+  ps->pev = pev;
+  ps->seq.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// pop
+//
+
+vscpEvent *
+CEventQueueMP::pop(void)
+{
+  size_t tail = m_tail.load(std::memory_order_relaxed);
+  slot *ps    = &m_pslots[tail & m_mask];
+
+  // Not written yet (or still being written)
+  if (ps->seq.load(std::memory_order_acquire) != (tail + 1)) {
+    return nullptr;
+  }
+
+  vscpEvent *pev = ps->pev;
+
+  // Free for the producers on the next lap
+  ps->seq.store(tail + m_mask + 1, std::memory_order_release);
+  m_tail.store(tail + 1, std::memory_order_relaxed);
+  return pev;
+}
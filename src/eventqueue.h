@@ -0,0 +1,229 @@
+// eventqueue.h
+//
+// This file is part of the VSCP (https://www.vscp.org)
+//
+// The MIT License (MIT)
+//
+// Copyright © 2000-2024 Ake Hedman, the VSCP Project
+// <akhe@vscp.org>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#if !defined(VSCP_EVENTQUEUE_H__INCLUDED_)
+#define VSCP_EVENTQUEUE_H__INCLUDED_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+#include <vscp.h>
+
+/// Size of a cache line. Head and tail are kept this far apart.
+#define EVENTQUEUE_CACHE_LINE 64
+
+/*!
+  Bounded lock free event queue for one producer and one consumer.
+
+  The worker thread is the only producer and the thread that reads
+  events for the host (VSCPRead) the only consumer. Events are
+  pointers in a ring that is allocated once, so nothing is allocated
+  when an event is queued. Head is only written by the producer. Head
+  and tail are in separate cache lines so the two threads do not
+  fight over the same line.
+
+  Tail is moved with compare and swap so the producer also can take
+  the oldest event with pop when the queue is full.
+
+  The number of events in the queue is held below a limit that can
+  be changed at any time up to the size of the ring.
+
+  The queue does not block. Waiting for events when the queue is
+  empty is done by the caller.
+*/
+
+class CEventQueue {
+
+public:
+  /*!
+    CTOR
+    @param size Max number of events. The ring is this size rounded
+                up to a power of two and the limit is set to size.
+  */
+  CEventQueue(size_t size = 1024);
+
+  /// DTOR
+  ~CEventQueue();
+
+  /*!
+    Add an event (producer only)
+    @param pev Event to add
+    @return true on success, false if the queue is full (limit
+            reached).
+  */
+  bool push(vscpEvent *pev);
+
+  /*!
+    Add several events and make them visible to the consumer at
+    once (producer only)
+    @param ppev Array of events
+    @param cnt Number of events in array
+    @return Number of events added. Less than cnt if the limit was
+            reached.
+  */
+  size_t push(vscpEvent *const *ppev, size_t cnt);
+
+  /*!
+    Take the oldest event (consumer, or producer to make room)
+    @return Event or nullptr if the queue is empty.
+  */
+  vscpEvent *pop(void);
+
+  /// Number of events in the queue
+  size_t size(void) const
+  {
+    return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+  };
+
+  /// Max number of events in the queue
+  size_t getLimit(void) const { return m_limit; };
+
+  /*!
+    Set max number of events in the queue. Events already in the
+    queue are kept if there are more.
+    @param limit New limit. Clamped to 1 - size of the ring.
+  */
+  void setLimit(size_t limit);
+
+  bool isEmpty(void) const { return (0 == size()); };
+
+private:
+  // Disable copy
+  CEventQueue(const CEventQueue &);
+  CEventQueue &operator=(const CEventQueue &);
+
+  /*!
+    Event slots
+  */
+  std::atomic<vscpEvent *> *m_pslots;
+
+  /*!
+    Number of slots minus one (number of slots is a power of two)
+  */
+  size_t m_mask;
+
+  /*!
+    Max number of events in the queue (<= m_mask + 1)
+  */
+  size_t m_limit;
+
+  char m_pad0[EVENTQUEUE_CACHE_LINE];
+
+  /*!
+    Write position. Free running, wrapped with m_mask on use.
+  */
+  std::atomic<size_t> m_head;
+
+  char m_pad1[EVENTQUEUE_CACHE_LINE - sizeof(std::atomic<size_t>)];
+
+  /*!
+    Read position. Free running, wrapped with m_mask on use.
+  */
+  std::atomic<size_t> m_tail;
+
+  char m_pad2[EVENTQUEUE_CACHE_LINE - sizeof(std::atomic<size_t>)];
+};
+
+/*!
+  Bounded lock free event queue for many producers and one consumer.
+
+  Used for events from the host (VSCPWrite) that may be written from
+  more than one thread. Each slot has a sequence number that tells
+  if it is free to write or ready to read so producers only have to
+  agree on the write position (compare and swap) and never wait for
+  each other or for the consumer.
+*/
+
+class CEventQueueMP {
+
+public:
+  /*!
+    CTOR
+    @param size Max number of events. Rounded up to a power of two.
+  */
+  CEventQueueMP(size_t size = 256);
+
+  /// DTOR
+  ~CEventQueueMP();
+
+  /*!
+    Add an event (any thread)
+    @param pev Event to add
+    @return true on success, false if the queue is full.
+  */
+  bool push(vscpEvent *pev);
+
+  /*!
+    Take the oldest event (consumer only)
+    @return Event or nullptr if the queue is empty.
+  */
+  vscpEvent *pop(void);
+
+  /// Max number of events in the queue
+  size_t getSize(void) const { return m_mask + 1; };
+
+private:
+  // Disable copy
+  CEventQueueMP(const CEventQueueMP &);
+  CEventQueueMP &operator=(const CEventQueueMP &);
+
+  struct slot {
+    std::atomic<size_t> seq;  // == pos: free, == pos + 1: holds event
+    vscpEvent *pev;
+  };
+
+  /*!
+    Event slots
+  */
+  slot *m_pslots;
+
+  /*!
+    Number of slots minus one (number of slots is a power of two)
+  */
+  size_t m_mask;
+
+  char m_pad0[EVENTQUEUE_CACHE_LINE];
+
+  /*!
+    Write position. Free running, wrapped with m_mask on use.
+  */
+  std::atomic<size_t> m_head;
+
+  char m_pad1[EVENTQUEUE_CACHE_LINE - sizeof(std::atomic<size_t>)];
+
+  /*!
+    Read position. Free running, wrapped with m_mask on use.
+  */
+  std::atomic<size_t> m_tail;
+
+  char m_pad2[EVENTQUEUE_CACHE_LINE - sizeof(std::atomic<size_t>)];
+};
+
+#endif // VSCP_EVENTQUEUE_H__INCLUDED_
@@ -0,0 +1,245 @@
+// obis.cpp
+//
+// This file is part of the VSCP (https://www.vscp.org)
+//
+// The MIT License (MIT)
+//
+// Copyright © 2000-2024 Ake Hedman, the VSCP Project
+// <akhe@vscp.org>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <algorithm>
+
+#include "obis.h"
+
+// Seeds to try for each table size before going to a larger table
+#define OBIS_SEED_TRIES 256
+
+// Max table size in slots per key
+#define OBIS_MAX_LOAD_FACTOR 8
+
+///////////////////////////////////////////////////////////////////////////////
+// obis_parse
+//
+
+size_t
+obis_parse(const char *p, size_t len, uint64_t *pkey)
+{
+  // Separator expected after group A..E
+  static const char sep[] = { '-', ':', '.', '.', '*' };
+  unsigned val[6]         = { 0, 0, 0, 0, 0, 255 };
+  size_t pos              = 0;
+  int group;
+
+  for (group = 0; group < 6; group++) {
+
+    size_t start = pos;
+    unsigned v   = 0;
+    while ((pos < len) && (p[pos] >= '0') && (p[pos] <= '9')) {
+      v = v * 10 + (p[pos] - '0');
+      if (v > 255) {
+        return 0;
+      }
+      pos++;
+    }
+
+    // Empty group
+    if (pos == start) {
+      return 0;
+    }
+
+    val[group] = v;
+
+    // F is optional
+    if ((5 == group) || (pos >= len) || (sep[group] != p[pos])) {
+      break;
+    }
+    pos++;
+  }
+
+  // A..E are required
+  if (group < 4) {
+    return 0;
+  }
+
+  *pkey = OBIS_KEY(val[0], val[1], val[2], val[3], val[4], val[5]);
+  return pos;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// CTOR
+//
+
+CObisMap::CObisMap()
+{
+  m_seed     = 0;
+  m_shift    = 64;
+  m_mask     = 0;
+  m_cntKeys  = 0;
+  m_bPerfect = true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// DTOR
+//
+
+CObisMap::~CObisMap()
+{
+  ;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// clear
+//
+
+void
+CObisMap::clear(void)
+{
+  m_pending.clear();
+  m_items.clear();
+  m_table.clear();
+  m_seed     = 0;
+  m_shift    = 64;
+  m_mask     = 0;
+  m_cntKeys  = 0;
+  m_bPerfect = true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// add
+//
+
+void
+CObisMap::add(uint64_t key, CP1Item *pItem)
+{
+  m_pending.push_back(std::make_pair(key, pItem));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// fill
+//
+
+size_t
+CObisMap::fill(const std::vector<obis_slot> &groups)
+{
+  size_t cntMoved = 0;
+
+  for (auto &slot : m_table) {
+    slot.count = 0;
+  }
+
+  for (auto const &group : groups) {
+    size_t idx = hash(group.key);
+    if (m_table[idx].count) {
+      cntMoved++;
+      while (m_table[idx].count) {
+        idx = (idx + 1) & m_mask;
+      }
+    }
+    m_table[idx] = group;
+  }
+
+  return cntMoved;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// build
+//
+
+void
+CObisMap::build(void)
+{
+  std::vector<obis_slot> groups;
+
+  // Put items with the same key next to each other. Stable sort keeps
+  // configuration order within a key.
+  std::stable_sort(m_pending.begin(),
+                   m_pending.end(),
+                   [](const std::pair<uint64_t, CP1Item *> &a, const std::pair<uint64_t, CP1Item *> &b) {
+                     return a.first < b.first;
+                   });
+
+  m_items.clear();
+  for (auto const &item : m_pending) {
+    if (groups.empty() || (groups.back().key != item.first)) {
+      obis_slot slot;
+      slot.key   = item.first;
+      slot.first = (uint32_t) m_items.size();
+      slot.count = 0;
+      groups.push_back(slot);
+    }
+    groups.back().count++;
+    m_items.push_back(item.second);
+  }
+
+  m_cntKeys = groups.size();
+  if (!m_cntKeys) {
+    m_table.clear();
+    m_mask     = 0;
+    m_bPerfect = true;
+    return;
+  }
+
+  // Start with a table at least twice the number of keys
+  size_t size = 2;
+  unsigned bits = 1;
+  while (size < (2 * m_cntKeys)) {
+    size <<= 1;
+    bits++;
+  }
+
+  uint64_t bestSeed = 0;
+  size_t bestSize   = size;
+  size_t bestMoved  = (size_t) -1;
+
+  for (; size <= (OBIS_MAX_LOAD_FACTOR * 2 * m_cntKeys); size <<= 1, bits++) {
+
+    m_table.assign(size, obis_slot());
+    m_mask  = size - 1;
+    m_shift = 64 - bits;
+
+    for (uint64_t seed = 0; seed < OBIS_SEED_TRIES; seed++) {
+      m_seed       = seed * 0xD6E8FEB86659FD93ULL;
+      size_t moved = fill(groups);
+      if (moved < bestMoved) {
+        bestMoved = moved;
+        bestSeed  = m_seed;
+        bestSize  = size;
+      }
+      if (!moved) {
+        m_bPerfect = true;
+        return;
+      }
+    }
+  }
+
+  // No perfect seed found, use the one with fewest collisions
+  m_table.assign(bestSize, obis_slot());
+  m_mask  = bestSize - 1;
+  m_shift = 64;
+  while ((size_t) 1 << (64 - m_shift) < bestSize) {
+    m_shift--;
+  }
+  m_seed     = bestSeed;
+  m_bPerfect = false;
+  fill(groups);
+}
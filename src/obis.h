@@ -0,0 +1,167 @@
+// obis.h
+//
+// This file is part of the VSCP (https://www.vscp.org)
+//
+// The MIT License (MIT)
+//
+// Copyright © 2000-2024 Ake Hedman, the VSCP Project
+// <akhe@vscp.org>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#if !defined(VSCP_OBIS_H__INCLUDED_)
+#define VSCP_OBIS_H__INCLUDED_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+class CP1Item;
+
+/*!
+  Pack OBIS code A-B:C.D.E*F into a 48-bit key
+*/
+#define OBIS_KEY(a, b, c, d, e, f)                                                                                     \
+  (((uint64_t) (a) << 40) | ((uint64_t) (b) << 32) | ((uint64_t) (c) << 24) | ((uint64_t) (d) << 16) |                 \
+   ((uint64_t) (e) << 8) | (uint64_t) (f))
+
+/*!
+  Parse an OBIS code on the form A-B:C.D.E or A-B:C.D.E*F into a key.
+  The F group defaults to 255 when not given.
+  @param p Pointer to text to parse.
+  @param len Number of characters available.
+  @param pkey Set to the key on success.
+  @return Number of characters used for the code. Zero if the text
+          does not start with a valid OBIS code.
+*/
+size_t
+obis_parse(const char *p, size_t len, uint64_t *pkey);
+
+/*!
+  OBIS code to P1 item dispatch table.
+
+  Keys are added at config load and then build() lays them out in
+  an open addressing table. build() searches for a hash seed that
+  gives no collisions at all, so a lookup normally touches one slot
+  only. If no such seed is found the table still works with linear
+  probing. Several items can use the same OBIS code, they are then
+  all returned by find() in configuration order.
+*/
+
+class CObisMap {
+
+public:
+  /// CTOR
+  CObisMap();
+
+  /// DTOR
+  ~CObisMap();
+
+  /// Remove all keys and items
+  void clear(void);
+
+  /*!
+    Add item for an OBIS key. The item can not be found until
+    build() has been called.
+    @param key OBIS key
+    @param pItem Item to handle lines with this key.
+  */
+  void add(uint64_t key, CP1Item *pItem);
+
+  /*!
+    Build lookup table from added items.
+  */
+  void build(void);
+
+  /*!
+    Find items for an OBIS key
+    @param key OBIS key to look for.
+    @param pppItems Set to point at the first item found.
+    @return Number of items found.
+  */
+  size_t find(uint64_t key, CP1Item *const **pppItems) const
+  {
+    if (!m_mask) {
+      return 0;
+    }
+
+    size_t idx = hash(key);
+    for (;;) {
+      const obis_slot &slot = m_table[idx];
+      if (!slot.count) {
+        return 0;
+      }
+      if (slot.key == key) {
+        *pppItems = &m_items[slot.first];
+        return slot.count;
+      }
+      idx = (idx + 1) & m_mask;
+    }
+  };
+
+  /// Number of distinct keys in the table
+  size_t getKeyCount(void) const { return m_cntKeys; };
+
+  /// True if the table has no collisions
+  bool isPerfect(void) const { return m_bPerfect; };
+
+private:
+  struct obis_slot {
+    uint64_t key;
+    uint32_t first; // Index of first item in m_items
+    uint32_t count; // Number of items, zero for an empty slot
+  };
+
+  size_t hash(uint64_t key) const
+  {
+    return (size_t) (((key ^ m_seed) * 0x9E3779B97F4A7C15ULL) >> m_shift) & m_mask;
+  };
+
+  /*!
+    Fill table with the grouped keys using current seed/size
+    @return Number of keys that did not land in their home slot.
+  */
+  size_t fill(const std::vector<obis_slot> &groups);
+
+  /*!
+    Items added, not yet built
+  */
+  std::vector<std::pair<uint64_t, CP1Item *>> m_pending;
+
+  /*!
+    Items ordered so that all items for one key are adjacent
+  */
+  std::vector<CP1Item *> m_items;
+
+  /*!
+    Hash table
+  */
+  std::vector<obis_slot> m_table;
+
+  uint64_t m_seed;
+  unsigned m_shift;
+  size_t m_mask;
+  size_t m_cntKeys;
+  bool m_bPerfect;
+};
+
+#endif // VSCP_OBIS_H__INCLUDED_
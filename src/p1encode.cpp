@@ -0,0 +1,324 @@
+// p1encode.cpp
+//
+// This file is part of the VSCP (https://www.vscp.org)
+//
+// The MIT License (MIT)
+//
+// Copyright © 2000-2024 Ake Hedman, the VSCP Project
+// <akhe@vscp.org>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <vscp.h>
+#include <vscp_class.h>
+
+#include "p1encode.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// fixedIntegerData
+//
+// Write a fixed point value as a signed big endian integer using as
+// few bytes as possible. Digits are dropped until the value fits in
+// maxbytes. Returns number of bytes written.
+//
+
+static uint8_t
+fixedIntegerData(uint8_t *pdata, p1_fixed *pval, uint8_t maxbytes)
+{
+  int64_t limit = (int64_t) 1 << (8 * maxbytes - 1);
+  while ((pval->mantissa >= limit) || (pval->mantissa < -limit)) {
+    p1_fixed_drop_digit(pval);
+  }
+
+  uint8_t cnt = 1;
+  while ((cnt < maxbytes) &&
+         ((pval->mantissa >= ((int64_t) 1 << (8 * cnt - 1))) ||
+          (pval->mantissa < -((int64_t) 1 << (8 * cnt - 1))))) {
+    cnt++;
+  }
+
+  uint64_t v = (uint64_t) pval->mantissa;
+  for (int i = cnt - 1; i >= 0; i--) {
+    pdata[i] = (uint8_t) (v & 0xff);
+    v >>= 8;
+  }
+
+  return cnt;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// putBigEndian
+//
+
+static void
+putBigEndian(uint8_t *pdata, uint64_t v, int cnt)
+{
+  for (int i = cnt - 1; i >= 0; i--) {
+    pdata[i] = (uint8_t) (v & 0xff);
+    v >>= 8;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// level1Data
+//
+// Level I data coding byte followed by the value. size is the number
+// of bytes available including the coding byte. The coding is a
+// template argument so each coding gets its own function without any
+// switch at run time. Returns number of bytes written or zero if the
+// value does not fit.
+//
+
+template <uint8_t coding>
+static uint16_t
+level1Data(uint8_t *pdata, uint8_t size, const p1_value &val, uint8_t unit, uint8_t sensoridx)
+{
+  p1_fixed fixed = val.fixed;
+
+  pdata[0] = coding | ((unit & 3) << 3) | (sensoridx & 7);
+
+  if (VSCP_DATACODING_NORMALIZED == coding) {
+    // Exponent must fit in seven bits
+    while (fixed.exp < -127) {
+      p1_fixed_drop_digit(&fixed);
+    }
+    // Mantissa first, dropping digits to fit raises the exponent
+    uint8_t cnt = fixedIntegerData(pdata + 2, &fixed, size - 2);
+    if (fixed.exp > 127) {
+      return 0;
+    }
+    pdata[1] = (fixed.exp < 0) ? (0x80 | (uint8_t) (-fixed.exp)) : (uint8_t) fixed.exp;
+    return 2 + cnt;
+  }
+  else if (VSCP_DATACODING_INTEGER == coding) {
+    // Integer part only
+    while (fixed.exp < 0) {
+      fixed.mantissa /= 10;
+      fixed.exp++;
+    }
+    while (fixed.exp > 0) {
+      if ((fixed.mantissa > (INT64_MAX / 10)) || (fixed.mantissa < (INT64_MIN / 10))) {
+        return 0;
+      }
+      fixed.mantissa *= 10;
+      fixed.exp--;
+    }
+    int64_t limit = (int64_t) 1 << (8 * (size - 1) - 1);
+    if ((fixed.mantissa >= limit) || (fixed.mantissa < -limit)) {
+      return 0;
+    }
+    return 1 + fixedIntegerData(pdata + 1, &fixed, size - 1);
+  }
+  else if (VSCP_DATACODING_STRING == coding) {
+    char buf[32];
+    size_t len = p1_format_fixed(buf, sizeof(buf), fixed);
+    if (!len) {
+      return 0;
+    }
+    // Drop decimals that do not fit
+    if (len > (size_t) (size - 1)) {
+      const char *pdot = (const char *) memchr(buf, '.', len);
+      if ((nullptr == pdot) || ((pdot - buf) > (size - 1))) {
+        return 0;
+      }
+      len = size - 1;
+      if ('.' == buf[len - 1]) {
+        len--;
+      }
+    }
+    memcpy(pdata + 1, buf, len);
+    return (uint16_t) (1 + len);
+  }
+  else {
+    // Single precision float, MSB first
+    float f = (float) val.value;
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    putBigEndian(pdata + 1, bits, 4);
+    return 5;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// encodeMeasurement
+//
+// CLASS1.MEASUREMENT
+//
+
+template <uint8_t coding>
+static bool
+encodeMeasurement(vscpEventEx *pex, uint16_t pos, const p1_value &val, uint8_t unit, uint8_t sensoridx)
+{
+  uint16_t cnt = level1Data<coding>(pex->data + pos, 8 - pos, val, unit, sensoridx);
+  pex->sizeData = pos + cnt;
+  return (0 != cnt);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// encodeDouble
+//
+// CLASS1.MEASUREMENT64, 64 bit double MSB first
+//
+
+static bool
+encodeDouble(vscpEventEx *pex, uint16_t pos, const p1_value &val, uint8_t unit, uint8_t sensoridx)
+{
+  uint64_t bits;
+  memcpy(&bits, &val.value, sizeof(bits));
+  putBigEndian(pex->data + pos, bits, 8);
+  pex->sizeData = pos + 8;
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// encodeFloat
+//
+// CLASS1.MEASUREMENT32, 32 bit float MSB first
+//
+
+static bool
+encodeFloat(vscpEventEx *pex, uint16_t pos, const p1_value &val, uint8_t unit, uint8_t sensoridx)
+{
+  float f = (float) val.value;
+  uint32_t bits;
+  memcpy(&bits, &f, sizeof(bits));
+  putBigEndian(pex->data + pos, bits, 4);
+  pex->sizeData = pos + 4;
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// encodeLevel2String
+//
+// CLASS2.MEASUREMENT_STR, value as a string after sensor index, zone,
+// subzone and unit.
+//
+
+static bool
+encodeLevel2String(vscpEventEx *pex, uint16_t pos, const p1_value &val, uint8_t unit, uint8_t sensoridx)
+{
+  // Six decimals as "%f" but always with '.' whatever the locale
+  double scaled = val.value * 1e6;
+  if (!(fabs(scaled) < 9e18)) {
+    return false;
+  }
+
+  p1_fixed fixed = { llround(scaled), -6 };
+  size_t len     = p1_format_fixed((char *) pex->data + pos, VSCP_MAX_DATA - pos, fixed);
+  if (!len) {
+    return false;
+  }
+
+  pex->data[3]  = unit;
+  pex->sizeData = (uint16_t) (pos + len);
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// encodeLevel2FixedString
+//
+// CLASS2.MEASUREMENT_STR with exactly the digits from the meter
+//
+
+static bool
+encodeLevel2FixedString(vscpEventEx *pex, uint16_t pos, const p1_value &val, uint8_t unit, uint8_t sensoridx)
+{
+  size_t len = p1_format_fixed((char *) pex->data + pos, VSCP_MAX_DATA - pos, val.fixed);
+  if (!len) {
+    return false;
+  }
+
+  pex->data[3]  = unit;
+  pex->sizeData = (uint16_t) (pos + len);
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// encodeLevel2Float
+//
+// CLASS2.MEASUREMENT_FLOAT, 64 bit double MSB first after sensor
+// index, zone, subzone and unit.
+//
+
+static bool
+encodeLevel2Float(vscpEventEx *pex, uint16_t pos, const p1_value &val, uint8_t unit, uint8_t sensoridx)
+{
+  uint64_t bits;
+  memcpy(&bits, &val.value, sizeof(bits));
+  putBigEndian(pex->data + pos, bits, 8);
+  pex->data[3]  = unit;
+  pex->sizeData = pos + 8;
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// p1_get_encoder
+//
+
+p1_encoder
+p1_get_encoder(uint16_t vscp_class, uint8_t coding, bool bFixedPoint, bool *pbFixed)
+{
+  *pbFixed = false;
+
+  switch (vscp_class) {
+
+    // Data coding byte and value. The zone classes have sensor index,
+    // zone and subzone in front, set by the template.
+    case VSCP_CLASS1_MEASUREMENT:
+    case VSCP_CLASS1_MEASUREZONE:
+    case VSCP_CLASS1_SETVALUEZONE:
+      *pbFixed = true;
+      switch (coding) {
+        case VSCP_DATACODING_STRING:
+          return encodeMeasurement<VSCP_DATACODING_STRING>;
+        case VSCP_DATACODING_INTEGER:
+          return encodeMeasurement<VSCP_DATACODING_INTEGER>;
+        case VSCP_DATACODING_NORMALIZED:
+          return encodeMeasurement<VSCP_DATACODING_NORMALIZED>;
+        case VSCP_DATACODING_SINGLE:
+        case VSCP_DATACODING_DOUBLE:
+          *pbFixed = false;
+          return encodeMeasurement<VSCP_DATACODING_SINGLE>;
+        default:
+          *pbFixed = false;
+          return nullptr;
+      }
+
+    case VSCP_CLASS1_MEASUREMENT64:
+      return encodeDouble;
+
+    case VSCP_CLASS1_MEASUREMENT32:
+      return encodeFloat;
+
+    case VSCP_CLASS2_MEASUREMENT_STR:
+      *pbFixed = bFixedPoint;
+      return bFixedPoint ? encodeLevel2FixedString : encodeLevel2String;
+
+    case VSCP_CLASS2_MEASUREMENT_FLOAT:
+      return encodeLevel2Float;
+  }
+
+  return nullptr;
+}
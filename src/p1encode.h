@@ -0,0 +1,81 @@
+// p1encode.h
+//
+// This file is part of the VSCP (https://www.vscp.org)
+//
+// The MIT License (MIT)
+//
+// Copyright © 2000-2024 Ake Hedman, the VSCP Project
+// <akhe@vscp.org>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#if !defined(VSCP_P1ENCODE_H__INCLUDED_)
+#define VSCP_P1ENCODE_H__INCLUDED_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vscp.h>
+
+#include "p1line.h"
+
+/*!
+  Measurement value handed to an encoder. fixed is only set if the
+  encoder uses it (see p1_get_encoder).
+*/
+struct p1_value {
+  double value;
+  p1_fixed fixed;
+};
+
+/*!
+  Encoder for the value part of a measurement event. One encoder
+  exists for each class and Level I coding, the right one is picked
+  for an item when the configuration is loaded.
+  @param pex Event set up from the item template.
+  @param pos Number of data bytes already set by the template.
+  @param val Value to encode.
+  @param unit VSCP unit code.
+  @param sensoridx Sensor index.
+  @return true on success, false if the value can't be encoded.
+*/
+typedef bool (*p1_encoder)(vscpEventEx *pex, uint16_t pos, const p1_value &val, uint8_t unit, uint8_t sensoridx);
+
+/*!
+  Get the encoder for a class
+
+  Supported classes are CLASS1.MEASUREMENT (10), CLASS1.MEASUREZONE
+  (65) and CLASS1.SETVALUEZONE (85) with string, integer, normalized
+  integer and single coding, CLASS1.MEASUREMENT64 (60),
+  CLASS1.MEASUREMENT32 (70), CLASS2.MEASUREMENT_STR (1040) and
+  CLASS2.MEASUREMENT_FLOAT (1060). Double coding does not fit a
+  Level I event and is sent as single.
+
+  @param vscp_class VSCP class of the item.
+  @param coding Level I data coding of the item.
+  @param bFixedPoint true if the item is handled as fixed point.
+  @param pbFixed Set to true if the encoder uses the fixed point
+                 value, false if it uses the double.
+  @return Encoder or nullptr if the class/coding is not supported.
+*/
+p1_encoder
+p1_get_encoder(uint16_t vscp_class, uint8_t coding, bool bFixedPoint, bool *pbFixed);
+
+#endif // VSCP_P1ENCODE_H__INCLUDED_
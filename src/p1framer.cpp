@@ -0,0 +1,157 @@
+// p1framer.cpp
+//
+// This file is part of the VSCP (https://www.vscp.org)
+//
+// The MIT License (MIT)
+//
+// Copyright © 2000-2024 Ake Hedman, the VSCP Project
+// <akhe@vscp.org>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "p1framer.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// CTOR
+//
+
+CP1Framer::CP1Framer(size_t size)
+  : m_ring(size)
+{
+  m_pline = new char[m_ring.capacity()];
+  reset();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// DTOR
+//
+
+CP1Framer::~CP1Framer()
+{
+  delete[] m_pline;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// reset
+//
+
+void
+CP1Framer::reset(void)
+{
+  m_ring.clear();
+  m_scanned         = 0;
+  m_bDiscard        = false;
+  m_cntLines        = 0;
+  m_cntOverruns     = 0;
+  m_cntOverrunBytes = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// readFrom
+//
+
+ssize_t
+CP1Framer::readFrom(int fd)
+{
+  return m_ring.readFrom(fd);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// write
+//
+
+size_t
+CP1Framer::write(const char *pbuf, size_t len)
+{
+  return m_ring.write(pbuf, len);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// discard
+//
+
+void
+CP1Framer::discard(void)
+{
+  size_t eol = m_ring.find(0x0a);
+
+  if (CRingBuffer::npos == eol) {
+    m_cntOverrunBytes += m_ring.size();
+    m_ring.clear();
+    return;
+  }
+
+  // End of the long line found. Back to normal
+  m_cntOverrunBytes += eol + 1;
+  m_ring.consume(eol + 1);
+  m_scanned  = 0;
+  m_bDiscard = false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// getLine
+//
+
+bool
+CP1Framer::getLine(const char **ppline, size_t *plen)
+{
+  if (m_bDiscard) {
+    discard();
+    if (m_bDiscard) {
+      return false;
+    }
+  }
+
+  size_t eol = m_ring.find(0x0a, m_scanned);
+  if (CRingBuffer::npos == eol) {
+
+    // Remember how far we have looked
+    m_scanned = m_ring.size();
+
+    // A full buffer without a line end. The line can't be handled,
+    // drop it up to the next line end.
+    if (m_ring.isFull()) {
+      m_cntOverruns++;
+      m_cntOverrunBytes += m_ring.size();
+      m_ring.clear();
+      m_scanned  = 0;
+      m_bDiscard = true;
+    }
+
+    return false;
+  }
+
+  size_t len = eol + 1;
+  if (m_ring.contiguous() >= len) {
+    *ppline = m_ring.front();
+  }
+  else {
+    m_ring.peek(m_pline, len);
+    *ppline = m_pline;
+  }
+  *plen = len;
+
+  // Data stays in place until more is written to the ring
+  m_ring.consume(len);
+  m_scanned = 0;
+  m_cntLines++;
+
+  return true;
+}
@@ -0,0 +1,142 @@
+// p1framer.h
+//
+// This file is part of the VSCP (https://www.vscp.org)
+//
+// The MIT License (MIT)
+//
+// Copyright © 2000-2024 Ake Hedman, the VSCP Project
+// <akhe@vscp.org>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#if !defined(VSCP_P1FRAMER_H__INCLUDED_)
+#define VSCP_P1FRAMER_H__INCLUDED_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "ringbuffer.h"
+
+/*!
+  Incremental line framer for P1 serial data.
+
+  Data is fed in any chunk size with readFrom() or write() and
+  complete lines are taken out with getLine(). State is kept
+  between calls, so a line that arrives in several reads is put
+  together correctly. The part of the buffer that has already been
+  searched for a line end is never searched again.
+
+  Lines are handed out as pointers into the input buffer. Only a
+  line that happens to wrap around the end of the ring is copied
+  (into a buffer allocated once). A line that does not fit in the
+  buffer is thrown away up to the next line end and counted as an
+  overrun.
+*/
+
+class CP1Framer {
+
+public:
+  /*!
+    CTOR
+    @param size Size of input buffer. This is also the longest
+                line that can be handled.
+  */
+  CP1Framer(size_t size = 4096);
+
+  /// DTOR
+  ~CP1Framer();
+
+  /*!
+    Read what is available from a file descriptor
+    @param fd File descriptor to read from
+    @return Number of bytes read or -1 on error (errno set).
+  */
+  ssize_t readFrom(int fd);
+
+  /*!
+    Feed data from memory
+    @param pbuf Pointer to data
+    @param len Number of bytes
+    @return Number of bytes taken. If not all data was taken, get
+            lines with getLine to make room and feed the rest.
+  */
+  size_t write(const char *pbuf, size_t len);
+
+  /*!
+    Get next complete line
+    @param ppline Set to point at the first character of the line.
+                  The pointer is valid until next call to readFrom,
+                  write or getLine.
+    @param plen Set to length of line including line end (LF).
+    @return true if a line was returned, false if no complete line
+            is available.
+  */
+  bool getLine(const char **ppline, size_t *plen);
+
+  /// Forget all buffered data and partial lines
+  void reset(void);
+
+  /// Size of the longest line that can be handled
+  size_t getMaxLineLength(void) const { return m_ring.capacity(); };
+
+  /// Number of complete lines delivered
+  uint64_t getLineCount(void) const { return m_cntLines; };
+
+  /// Number of lines thrown away because they were too long
+  uint64_t getOverrunCount(void) const { return m_cntOverruns; };
+
+  /// Number of bytes thrown away because of overruns
+  uint64_t getOverrunBytes(void) const { return m_cntOverrunBytes; };
+
+private:
+  /*!
+    Drop data while in discard state
+  */
+  void discard(void);
+
+  /*!
+    Input buffer
+  */
+  CRingBuffer m_ring;
+
+  /*!
+    Number of bytes from the start of the ring that already has
+    been searched for a line end.
+  */
+  size_t m_scanned;
+
+  /*!
+    True when the remainder of a too long line is being dropped
+  */
+  bool m_bDiscard;
+
+  /*!
+    Holds a line that wraps around the end of the ring
+  */
+  char *m_pline;
+
+  // Statistics
+  uint64_t m_cntLines;
+  uint64_t m_cntOverruns;
+  uint64_t m_cntOverrunBytes;
+};
+
+#endif // VSCP_P1FRAMER_H__INCLUDED_
@@ -26,7 +26,13 @@
 // SOFTWARE.
 //
 
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include <vscp.h>
+#include <vscp_class.h>
 
 #include "p1item.h"
 
@@ -45,7 +51,18 @@ CP1Item::CP1Item() {
   m_zone = 0;
   m_subzone = 0;
   m_level1Coding = VSCP_DATACODING_STRING;
-  m_factor = 1;
+  m_idxLastUnit = 0;
+  m_bFixedPoint = false;
+  m_valueGroup = 0;
+  m_timeGroup = P1_LINE_NO_GROUP;
+  memset(&m_exTemplate, 0, sizeof(m_exTemplate));
+  m_sizeTemplateData = 0;
+  m_encoder = nullptr;
+  m_bEncodeFixed = false;
+  m_bFiltered = false;
+  m_bActive = true;
+  m_pHeldEvent = nullptr;
+  setFactor(1);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -60,6 +77,18 @@ CP1Item::CP1Item(const std::string token,
                     uint8_t zone,
                     uint8_t subzone,
                     uint8_t level1Coding) {
+  m_idxLastUnit = 0;
+  m_bFixedPoint = false;
+  m_valueGroup = 0;
+  m_timeGroup = P1_LINE_NO_GROUP;
+  memset(&m_exTemplate, 0, sizeof(m_exTemplate));
+  m_sizeTemplateData = 0;
+  m_encoder = nullptr;
+  m_bEncodeFixed = false;
+  m_bFiltered = false;
+  m_bActive = true;
+  m_pHeldEvent = nullptr;
+  setFactor(1);
   initItem(token,
             description,
             vscp_class,
@@ -118,20 +147,218 @@ bool CP1Item::initItem(const std::string& token,
   return true;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// getValue
+//
+
+bool CP1Item::getValue(const CP1Line& line, double *pval)
+{
+  double value;
+  const char *p;
+  size_t len;
+
+  if (!line.getGroupValue(m_valueGroup, &p, &len) || !p1_parse_decimal(p, len, &value)) {
+    return false;
+  }
+
+  *pval = m_factor * value;
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// setFactor
+//
+
+void CP1Item::setFactor(double factor)
+{
+  m_factor = factor;
+
+  // Find integer m and exponent e so that factor = m * 10^e
+  m_bFactorExact = false;
+  m_factorMul    = 1;
+  m_factorExp    = 0;
+
+  double f = factor;
+  int exp  = 0;
+  while ((exp > -9) && (fabs(f - llround(f)) > (fabs(f) * 1e-12))) {
+    f *= 10;
+    exp--;
+  }
+
+  if ((fabs(f) < 1) || (fabs(f) >= 1e18) || (fabs(f - llround(f)) > (fabs(f) * 1e-12))) {
+    return;
+  }
+
+  int64_t mul = llround(f);
+  while (0 == (mul % 10)) {
+    mul /= 10;
+    exp++;
+  }
+
+  m_factorMul    = mul;
+  m_factorExp    = exp;
+  m_bFactorExact = true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// getFixedValue
+//
+
+bool CP1Item::getFixedValue(const CP1Line& line, p1_fixed *pval)
+{
+  const char *p;
+  size_t len;
+
+  if (!line.getGroupValue(m_valueGroup, &p, &len) || !p1_parse_fixed(p, len, pval)) {
+    return false;
+  }
+
+  if (!m_bFactorExact) {
+    // Factor is not a decimal number, go through double and keep
+    // the number of decimals the meter sent.
+    double value = m_factor * p1_fixed_to_double(*pval);
+    pval->mantissa = llround(value * pow(10, -pval->exp));
+    return true;
+  }
+
+  if (1 != m_factorMul) {
+    // Make room for the multiplication by dropping digits
+    while ((pval->mantissa > (INT64_MAX / llabs(m_factorMul))) ||
+           (pval->mantissa < (INT64_MIN / llabs(m_factorMul)))) {
+      p1_fixed_drop_digit(pval);
+    }
+    pval->mantissa *= m_factorMul;
+  }
+  pval->exp += m_factorExp;
+
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// getTime
+//
+
+bool CP1Item::getTime(const CP1Line& line, int utcOffset, int64_t *pt)
+{
+  const char *p;
+  size_t len;
+
+  if ((P1_LINE_NO_GROUP == m_timeGroup) || !line.getGroupValue(m_timeGroup, &p, &len)) {
+    return false;
+  }
+
+  return p1_parse_timestamp(p, len, utcOffset, pt);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// addUnit
+//
+
+void CP1Item::addUnit(const std::string& p1unit, uint8_t vscp_unit)
+{
+  for (auto& x : m_units) {
+    if (x.p1unit == p1unit) {
+      x.vscp_unit = vscp_unit;
+      return;
+    }
+  }
+
+  struct p1unit unit;
+  unit.p1unit    = p1unit;
+  unit.vscp_unit = vscp_unit;
+  m_units.push_back(unit);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // getUnit
 //
 
-int CP1Item::getUnit(const std::string& line)
+int CP1Item::getUnit(const CP1Line& line)
 {
-  size_t pos1_unit = line.find("*");
-  size_t pos2_unit = line.find(")");
-  int diff = pos2_unit - pos1_unit - 1;
+  const char *punit;
+  size_t len;
+
+  if (!line.getGroupUnit(m_valueGroup, &punit, &len)) {
+    return -1;
+  }
+
+  // Same unit as last time?
+  if (m_idxLastUnit < m_units.size()) {
+    const std::string& str = m_units[m_idxLastUnit].p1unit;
+    if ((str.length() == len) && (0 == memcmp(str.data(), punit, len))) {
+      return m_units[m_idxLastUnit].vscp_unit;
+    }
+  }
 
-  for (auto const& x : m_map_unit) {
-    if (x.first == line.substr(pos1_unit + 1, diff)) {
-      return x.second;
+  for (size_t i = 0; i < m_units.size(); i++) {
+    const std::string& str = m_units[i].p1unit;
+    if ((str.length() == len) && (0 == memcmp(str.data(), punit, len))) {
+      m_idxLastUnit = i;
+      return m_units[i].vscp_unit;
     }
   }
+
   return -1;
 }
+
+///////////////////////////////////////////////////////////////////////////////
+// buildEventTemplate
+//
+
+void CP1Item::buildEventTemplate(const uint8_t *pguid)
+{
+  memset(&m_exTemplate, 0, sizeof(m_exTemplate));
+  m_exTemplate.head       = VSCP_HEADER16_GUID_TYPE_STANDARD | VSCP_PRIORITY_NORMAL | VSCP_HEADER16_DUMB;
+  m_exTemplate.vscp_class = m_vscp_class;
+  m_exTemplate.vscp_type  = m_vscp_type;
+  memcpy(m_exTemplate.GUID, pguid, 16);
+  m_exTemplate.GUID[15] = m_guid_lsb;
+
+  switch (m_vscp_class) {
+
+    // Sensor index, zone, subzone, unit, value
+    case VSCP_CLASS2_MEASUREMENT_STR:
+    case VSCP_CLASS2_MEASUREMENT_FLOAT:
+      m_exTemplate.data[0] = m_sensorindex;
+      m_exTemplate.data[1] = m_zone;
+      m_exTemplate.data[2] = m_subzone;
+      m_exTemplate.data[3] = 0;
+      m_sizeTemplateData   = 4;
+      break;
+
+    // Sensor index, zone, subzone, data coding byte, value
+    case VSCP_CLASS1_MEASUREZONE:
+    case VSCP_CLASS1_SETVALUEZONE:
+      m_exTemplate.data[0] = m_sensorindex;
+      m_exTemplate.data[1] = m_zone;
+      m_exTemplate.data[2] = m_subzone;
+      m_sizeTemplateData   = 3;
+      break;
+
+    default:
+      m_sizeTemplateData = 0;
+      break;
+  }
+
+  m_exTemplate.sizeData = m_sizeTemplateData;
+
+  m_encoder = p1_get_encoder(m_vscp_class, m_level1Coding, m_bFixedPoint, &m_bEncodeFixed);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// initEventEx
+//
+
+uint16_t CP1Item::initEventEx(vscpEventEx &ex) const
+{
+  ex.crc        = 0;
+  ex.obid       = 0;
+  ex.head       = m_exTemplate.head;
+  ex.vscp_class = m_exTemplate.vscp_class;
+  ex.vscp_type  = m_exTemplate.vscp_type;
+  memcpy(ex.GUID, m_exTemplate.GUID, 16);
+  memcpy(ex.data, m_exTemplate.data, m_sizeTemplateData);
+  ex.sizeData = m_sizeTemplateData;
+
+  return m_sizeTemplateData;
+}
@@ -29,11 +29,20 @@
 #if !defined(VSCP_P1ITEM_H__INCLUDED_)
 #define VSCP_P1ITEM_H__INCLUDED_
 
+#include <atomic>
 #include <deque>
 #include <iostream>
 #include <map>
 #include <sstream>
 #include <string>
+#include <vector>
+
+#include <vscp.h>
+
+#include "alarm.h"
+#include "p1encode.h"
+#include "p1line.h"
+#include "p1time.h"
 
 class CP1Item {
 
@@ -85,21 +94,35 @@ public:
     @param p1unit Unit string for P1 unit (such as "kW", "V" and "A")
     @param vscp_unit VSCP unit code.
   */
-  void addUnit(const std::string &p1unit, uint8_t vscp_unit) { m_map_unit[p1unit] = vscp_unit; };
+  void addUnit(const std::string &p1unit, uint8_t vscp_unit);
 
   /*!
     Get measurement value
-    @param line Meter reding line
-    @return Measurement value as a double
+    @param line Parsed meter reading line
+    @param pval Set to measurement value (with factor applied)
+    @return true on success, false if value is not a valid number
+  */
+  bool getValue(const CP1Line &line, double *pval);
+
+  /*!
+    Get measurement value as an exact fixed point value. The factor
+    is applied without rounding if it is an integer times a power of
+    ten, otherwise the value is rounded to the number of decimals
+    the meter sent.
+    @param line Parsed meter reading line
+    @param pval Set to measurement value (with factor applied)
+    @return true on success, false if value is not a valid number
   */
-  double getValue(const std::string &line) { return (m_factor * std::stod(line.substr(10 + 1))); };
+  bool getFixedValue(const CP1Line &line, p1_fixed *pval);
 
   /*!
-    Get VSCP numerical unit code from textual unit
-    @param line Meter reding line
+    Get VSCP numerical unit code from textual unit. The unit that
+    matched last time is tried first, a meter always sends the same
+    unit for a code so this is normally the only compare done.
+    @param line Parsed meter reading line
     @return Unit as integer. -1 if not found
   */
-  int getUnit(const std::string &line);
+  int getUnit(const CP1Line &line);
 
 
   // Getters / Setters
@@ -108,13 +131,13 @@ public:
   /*
     Token
   */
-  std::string getToken(void) { return m_token; };
+  const std::string &getToken(void) const { return m_token; };
   void setToken(const std::string &token) { m_token = token; };
 
   /*
     Description
   */
-  std::string getDescription(void) { return m_description; };
+  const std::string &getDescription(void) const { return m_description; };
   void setDescription(const std::string &description) { m_description = description; };
 
   /*
@@ -163,14 +186,121 @@ public:
     Factor
   */
   double getFactor(void) { return m_factor; };
-  void setFactor(double factor) { m_factor = factor; };
+  void setFactor(double factor);
+
+  /*
+    Fixed point. If true values are handled as exact decimal
+    values from the meter all the way to the event.
+  */
+  bool isFixedPoint(void) const { return m_bFixedPoint; };
+  void setFixedPoint(bool bFixedPoint = true) { m_bFixedPoint = bFixedPoint; };
+
+  /*
+    Value group. Index of the (...) group on the line that holds
+    the value. 0 is the first group, negative values count from
+    the end (-1 is the last group).
+  */
+  int getValueGroup(void) const { return m_valueGroup; };
+  void setValueGroup(int idx) { m_valueGroup = idx; };
+
+  /*
+    Time group. Index of the (...) group on the line that holds a
+    timestamp for the value. P1_LINE_NO_GROUP if none.
+  */
+  int getTimeGroup(void) const { return m_timeGroup; };
+  void setTimeGroup(int idx) { m_timeGroup = idx; };
+
+  /*!
+    Get timestamp for value from the time group of the line
+    @param line Parsed meter reading line
+    @param utcOffset Meter offset from UTC in minutes (standard time)
+    @param pt Set to seconds since epoch (UTC)
+    @return true if the item has a time group and it holds a valid
+            timestamp.
+  */
+  bool getTime(const CP1Line &line, int utcOffset, int64_t *pt);
+
+  /*
+    Filtered. True if the receive filter rejects events from the
+    item. Set when the item index is built.
+  */
+  bool isFiltered(void) const { return m_bFiltered; };
+  void setFiltered(bool bFiltered = true) { m_bFiltered = bFiltered; };
+
+  /*
+    Active. False if the item has no events to send and no alarms,
+    lines for it are then not handled at all.
+  */
+  bool isActive(void) const { return m_bActive; };
+  void setActive(bool bActive = true) { m_bActive = bActive; };
+
+  /*
+    Held event. Newest event for the item that did not fit on the
+    receive queue (queue policy latest-per-item) or that the host
+    has not read yet (queue mode latest). nullptr if none.
+  */
+  vscpEvent *getHeldEvent(void) const { return m_pHeldEvent.load(std::memory_order_acquire); };
+  void setHeldEvent(vscpEvent *pev) { m_pHeldEvent.store(pev, std::memory_order_release); };
+  vscpEvent *exchangeHeldEvent(vscpEvent *pev) { return m_pHeldEvent.exchange(pev, std::memory_order_acq_rel); };
+
+  /*
+    Alarms that test the value of the item. Built from the alarms in
+    the configuration when the item index is built.
+  */
+  std::vector<CAlarm> &getAlarms(void) { return m_alarms; };
+  bool hasAlarms(void) const { return !m_alarms.empty(); };
 
   /*
     Storage name
   */
-  std::string getStorageName(void) { return m_storageName; };
+  const std::string &getStorageName(void) const { return m_storageName; };
   void setStorageName(const std::string& storage) { m_storageName = storage; };
 
+  /*!
+    Build the event template for the item from its current
+    settings and pick the encoder for its class and coding. Must
+    be called again if the item is changed.
+    @param pguid Driver GUID (16 bytes). The lsb is replaced with
+                 the GUID lsb of the item.
+  */
+  void buildEventTemplate(const uint8_t *pguid);
+
+  /*!
+    Set up an event from the template. Head, class, type and GUID
+    are set and the data bytes that are the same for every event
+    from the item (sensor index, zone, subzone for Level II) are
+    filled in. Only the value, unit and time are left to set.
+    @param ex Event to set up
+    @return Number of data bytes set, the value goes here.
+  */
+  uint16_t initEventEx(vscpEventEx &ex) const;
+
+  /*!
+    True if the encoder of the item uses the exact fixed point
+    value. The value must then be read with getFixedValue.
+  */
+  bool isEncodeFixed(void) const { return m_bEncodeFixed; };
+
+  /*!
+    True if the class and coding of the item has an encoder
+  */
+  bool hasEncoder(void) const { return (nullptr != m_encoder); };
+
+  /*!
+    Encode value and unit into an event set up with initEventEx.
+    The encoder was picked for the class and coding of the item by
+    buildEventTemplate.
+    @param ex Event set up with initEventEx
+    @param pos Value returned from initEventEx
+    @param val Value to encode
+    @param unit VSCP unit code
+    @return true on success
+  */
+  bool encode(vscpEventEx &ex, uint16_t pos, const p1_value &val, uint8_t unit) const
+  {
+    return (nullptr != m_encoder) && m_encoder(&ex, pos, val, unit, m_sensorindex);
+  };
+
 private:
   /*!
     Measurement value id such as "1-0:1.8.0"
@@ -232,15 +362,93 @@ private:
   */
   double m_factor;
 
+  /*
+    Factor as m_factorMul * 10^m_factorExp for fixed point
+    values. m_bFactorExact is false if the factor can't be
+    written this way.
+  */
+  int64_t m_factorMul;
+  int m_factorExp;
+  bool m_bFactorExact;
+
+  /*
+    True to handle values as fixed point
+  */
+  bool m_bFixedPoint;
+
+  /*
+    Group on line that holds value
+  */
+  int m_valueGroup;
+
+  /*
+    Group on line that holds timestamp or P1_LINE_NO_GROUP
+  */
+  int m_timeGroup;
+
+  /*
+    True if the receive filter rejects events from the item
+  */
+  bool m_bFiltered;
+
+  /*
+    False if there is nothing to do for the item
+  */
+  bool m_bActive;
+
+  /*
+    Newest event not on the receive queue yet or nullptr. Taken by
+    the host thread in queue mode latest.
+  */
+  std::atomic<vscpEvent *> m_pHeldEvent;
+
+  /*
+    Alarms for the value of the item
+  */
+  std::vector<CAlarm> m_alarms;
+
   /*
     Name that value will be stored as
   */
   std::string m_storageName;
 
   /*!
-    Maps P1 unit to VSCP unit code
+    P1 unit to VSCP unit code
+  */
+  struct p1unit {
+    std::string p1unit;
+    uint8_t vscp_unit;
+  };
+
+  /*!
+    Units for this item
+  */
+  std::vector<p1unit> m_units;
+
+  /*!
+    Index in m_units of last found unit
+  */
+  size_t m_idxLastUnit;
+
+  /*!
+    Event template, see buildEventTemplate
+  */
+  vscpEventEx m_exTemplate;
+
+  /*!
+    Number of data bytes in the template
+  */
+  uint16_t m_sizeTemplateData;
+
+  /*!
+    Encoder for class and coding, nullptr if not supported
+  */
+  p1_encoder m_encoder;
+
+  /*!
+    True if m_encoder uses the fixed point value
   */
-  std::map<std::string, uint8_t> m_map_unit;
+  bool m_bEncodeFixed;
 
 };
 
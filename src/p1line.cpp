@@ -0,0 +1,369 @@
+// p1line.cpp
+//
+// This file is part of the VSCP (https://www.vscp.org)
+//
+// The MIT License (MIT)
+//
+// Copyright © 2000-2024 Ake Hedman, the VSCP Project
+// <akhe@vscp.org>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <string.h>
+
+#include "p1line.h"
+
+// Exact powers of ten as doubles
+static const double pow10tab[] = { 1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                   1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+///////////////////////////////////////////////////////////////////////////////
+// p1_parse_decimal
+//
+
+bool
+p1_parse_decimal(const char *p, size_t len, double *pval)
+{
+  const char *pend = p + len;
+  bool bNegative   = false;
+  uint64_t mantissa = 0;
+  int digits        = 0; // Significant digits in mantissa
+  int exp10         = 0; // Power of ten to apply to mantissa
+  bool bDigits      = false;
+
+  if ((p < pend) && (('-' == *p) || ('+' == *p))) {
+    bNegative = ('-' == *p);
+    p++;
+  }
+
+  // Integer part
+  for (; (p < pend) && (*p >= '0') && (*p <= '9'); p++) {
+    bDigits = true;
+    if (digits < 19) {
+      mantissa = mantissa * 10 + (*p - '0');
+      if (mantissa) {
+        digits++;
+      }
+    }
+    else {
+      exp10++; // Too many digits, drop the least significant ones
+    }
+  }
+
+  // Fraction
+  if ((p < pend) && ('.' == *p)) {
+    p++;
+    for (; (p < pend) && (*p >= '0') && (*p <= '9'); p++) {
+      bDigits = true;
+      if (digits < 19) {
+        mantissa = mantissa * 10 + (*p - '0');
+        if (mantissa) {
+          digits++;
+        }
+        exp10--;
+      }
+    }
+  }
+
+  if (!bDigits || (p != pend)) {
+    return false;
+  }
+
+  // The mantissa and powers of ten up to 1e22 are exact as doubles
+  // if the mantissa fits in 53 bits, so the division is correctly
+  // rounded.
+  double value = (double) mantissa;
+  while (exp10 < -22) {
+    value /= 1e22;
+    exp10 += 22;
+  }
+  while (exp10 > 22) {
+    value *= 1e22;
+    exp10 -= 22;
+  }
+  if (exp10 < 0) {
+    value /= pow10tab[-exp10];
+  }
+  else {
+    value *= pow10tab[exp10];
+  }
+
+  *pval = bNegative ? -value : value;
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// p1_parse_fixed
+//
+
+bool
+p1_parse_fixed(const char *p, size_t len, p1_fixed *pval)
+{
+  const char *pend  = p + len;
+  bool bNegative    = false;
+  uint64_t mantissa = 0;
+  int digits        = 0;
+  int exp10         = 0;
+  bool bDigits      = false;
+
+  if ((p < pend) && (('-' == *p) || ('+' == *p))) {
+    bNegative = ('-' == *p);
+    p++;
+  }
+
+  for (; (p < pend) && (*p >= '0') && (*p <= '9'); p++) {
+    bDigits  = true;
+    mantissa = mantissa * 10 + (*p - '0');
+    if (mantissa && (++digits > 18)) {
+      return false;
+    }
+  }
+
+  if ((p < pend) && ('.' == *p)) {
+    p++;
+    for (; (p < pend) && (*p >= '0') && (*p <= '9'); p++) {
+      bDigits  = true;
+      mantissa = mantissa * 10 + (*p - '0');
+      if (mantissa && (++digits > 18)) {
+        return false;
+      }
+      exp10--;
+    }
+  }
+
+  if (!bDigits || (p != pend)) {
+    return false;
+  }
+
+  pval->mantissa = bNegative ? -(int64_t) mantissa : (int64_t) mantissa;
+  pval->exp      = exp10;
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// p1_format_fixed
+//
+
+size_t
+p1_format_fixed(char *pbuf, size_t size, const p1_fixed &val)
+{
+  char digits[24];
+  int cnt = 0;
+  size_t pos = 0;
+
+  uint64_t m = (val.mantissa < 0) ? (0 - (uint64_t) val.mantissa) : (uint64_t) val.mantissa;
+  do {
+    digits[cnt++] = (char) ('0' + (m % 10));
+    m /= 10;
+  } while (m);
+
+  // Digits before the decimal point (at least one)
+  int intdigits = cnt + val.exp;
+  int total     = (val.exp >= 0) ? (cnt + val.exp) : ((intdigits > 0) ? cnt + 1 : 2 - val.exp);
+  if ((size_t) (total + 2) > size) {
+    return 0;
+  }
+
+  if (val.mantissa < 0) {
+    pbuf[pos++] = '-';
+  }
+
+  if (val.exp >= 0) {
+    while (cnt) {
+      pbuf[pos++] = digits[--cnt];
+    }
+    for (int i = 0; i < val.exp; i++) {
+      pbuf[pos++] = '0';
+    }
+  }
+  else if (intdigits > 0) {
+    while (cnt > -val.exp) {
+      pbuf[pos++] = digits[--cnt];
+    }
+    pbuf[pos++] = '.';
+    while (cnt) {
+      pbuf[pos++] = digits[--cnt];
+    }
+  }
+  else {
+    pbuf[pos++] = '0';
+    pbuf[pos++] = '.';
+    for (int i = 0; i < -intdigits; i++) {
+      pbuf[pos++] = '0';
+    }
+    while (cnt) {
+      pbuf[pos++] = digits[--cnt];
+    }
+  }
+
+  pbuf[pos] = 0;
+  return pos;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// p1_fixed_to_double
+//
+
+double
+p1_fixed_to_double(const p1_fixed &val)
+{
+  double value = (double) val.mantissa;
+  int exp10    = val.exp;
+
+  while (exp10 < -22) {
+    value /= 1e22;
+    exp10 += 22;
+  }
+  while (exp10 > 22) {
+    value *= 1e22;
+    exp10 -= 22;
+  }
+
+  return (exp10 < 0) ? (value / pow10tab[-exp10]) : (value * pow10tab[exp10]);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// p1_fixed_drop_digit
+//
+
+void
+p1_fixed_drop_digit(p1_fixed *pval)
+{
+  int64_t rest = pval->mantissa % 10;
+  pval->mantissa /= 10;
+  if (rest >= 5) {
+    pval->mantissa++;
+  }
+  else if (rest <= -5) {
+    pval->mantissa--;
+  }
+  pval->exp++;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// CTOR
+//
+
+CP1Line::CP1Line()
+{
+  m_pline     = nullptr;
+  m_len       = 0;
+  m_lenId     = 0;
+  m_cntGroups = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// parse
+//
+
+bool
+CP1Line::parse(const char *pline, size_t len)
+{
+  m_pline     = pline;
+  m_len       = len;
+  m_lenId     = 0;
+  m_cntGroups = 0;
+
+  const char *pend  = pline + len;
+  const char *popen = (const char *) memchr(pline, '(', len);
+  if ((nullptr == popen) || (popen == pline)) {
+    return false;
+  }
+  m_lenId = popen - pline;
+
+  // One pass over the groups
+  while ((nullptr != popen) && (m_cntGroups < P1_LINE_MAX_GROUPS)) {
+
+    const char *pstart = popen + 1;
+    const char *pclose = (const char *) memchr(pstart, ')', pend - pstart);
+    if (nullptr == pclose) {
+      break;
+    }
+
+    const char *pstar = (const char *) memchr(pstart, '*', pclose - pstart);
+
+    p1group &group = m_groups[m_cntGroups++];
+    group.offset   = (uint32_t) (pstart - pline);
+    group.len      = (uint32_t) (pclose - pstart);
+    group.lenValue = (uint32_t) (((nullptr != pstar) ? pstar : pclose) - pstart);
+
+    popen = (const char *) memchr(pclose + 1, '(', pend - (pclose + 1));
+  }
+
+  return (m_cntGroups > 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// parse
+//
+
+bool
+CP1Line::parse(const char *pline, size_t len, const uint32_t *pdelims, size_t cnt, uint32_t base)
+{
+  bool bInGroup  = false;
+  uint32_t start = 0;
+  uint32_t star  = 0;
+  bool bStar     = false;
+
+  m_pline     = pline;
+  m_len       = len;
+  m_lenId     = 0;
+  m_cntGroups = 0;
+
+  for (size_t i = 0; i < cnt; i++) {
+
+    uint32_t pos = pdelims[i] - base;
+    char c       = pline[pos];
+
+    if (!bInGroup) {
+      if ('(' == c) {
+        if (!m_cntGroups) {
+          if (!pos) {
+            return false;
+          }
+          m_lenId = pos;
+        }
+        if (m_cntGroups >= P1_LINE_MAX_GROUPS) {
+          break;
+        }
+        start    = pos + 1;
+        bStar    = false;
+        bInGroup = true;
+      }
+      else if ('\n' == c) {
+        break;
+      }
+    }
+    else if (('*' == c) && !bStar) {
+      star  = pos;
+      bStar = true;
+    }
+    else if (')' == c) {
+      p1group &group = m_groups[m_cntGroups++];
+      group.offset   = start;
+      group.len      = pos - start;
+      group.lenValue = (bStar ? star : pos) - start;
+      bInGroup       = false;
+    }
+  }
+
+  return (m_cntGroups > 0);
+}
@@ -0,0 +1,216 @@
+// p1line.h
+//
+// This file is part of the VSCP (https://www.vscp.org)
+//
+// The MIT License (MIT)
+//
+// Copyright © 2000-2024 Ake Hedman, the VSCP Project
+// <akhe@vscp.org>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#if !defined(VSCP_P1LINE_H__INCLUDED_)
+#define VSCP_P1LINE_H__INCLUDED_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*!
+  Parse a decimal number such as "-0012.345". Does not depend on
+  the locale, '.' is always the decimal point.
+  @param p Pointer to text.
+  @param len Number of characters. All must be part of the number.
+  @param pval Set to value on success.
+  @return true on success, false if the text is not a valid number.
+*/
+bool
+p1_parse_decimal(const char *p, size_t len, double *pval);
+
+/*!
+  Exact decimal value. The value is mantissa * 10^exp.
+*/
+struct p1_fixed {
+  int64_t mantissa;
+  int exp;
+};
+
+/*!
+  Parse a decimal number such as "-0012.345" into a fixed point
+  value without going through floating point. "00040649.246" gives
+  mantissa 40649246 and exponent -3.
+  @param p Pointer to text.
+  @param len Number of characters. All must be part of the number.
+  @param pval Set to value on success.
+  @return true on success, false if the text is not a valid number
+          or has more than 18 significant digits.
+*/
+bool
+p1_parse_fixed(const char *p, size_t len, p1_fixed *pval);
+
+/*!
+  Format a fixed point value as a decimal string with all digits
+  kept, "40649.246" for the example above.
+  @param pbuf Buffer for the string.
+  @param size Size of buffer.
+  @param val Value to format.
+  @return Length of the string (without terminating zero) or zero
+          if the buffer is too small.
+*/
+size_t
+p1_format_fixed(char *pbuf, size_t size, const p1_fixed &val);
+
+/*!
+  Convert a fixed point value to the nearest double.
+*/
+double
+p1_fixed_to_double(const p1_fixed &val);
+
+/*!
+  Remove least significant digit of a fixed point value, rounding
+  half away from zero.
+*/
+void
+p1_fixed_drop_digit(p1_fixed *pval);
+
+/*!
+  Max number of (...) groups handled on a line. The power failure
+  event log (1-0:99.97.0) has two groups per logged failure.
+*/
+#define P1_LINE_MAX_GROUPS 32
+
+/*!
+  Group index meaning "no group"
+*/
+#define P1_LINE_NO_GROUP (-128)
+
+/*!
+  View of one P1 data line such as
+
+    1-0:1.8.0(00006678.394*kWh)
+    0-1:24.2.1(230614220000W)(01234.567*m3)
+
+  The line is split into the id (text before the first '(') and any
+  number of (...) groups. A group holds a value and optionally a unit
+  after a '*'. Nothing is copied, all parts point into the line buffer
+  and are valid as long as it is.
+*/
+
+class CP1Line {
+
+public:
+  /// CTOR
+  CP1Line();
+
+  /*!
+    Split a line into parts
+    @param pline Pointer to line. Line end is allowed.
+    @param len Length of line
+    @return true if the line has an id and at least one group.
+  */
+  bool parse(const char *pline, size_t len);
+
+  /*!
+    Split a line into parts using a delimiter index instead of
+    searching the line.
+    @param pline Pointer to line. Line end is allowed.
+    @param len Length of line
+    @param pdelims Offsets of all '\n', '(', '*' and ')' on the line
+    @param cnt Number of offsets
+    @param base Value to subtract from the offsets to get the offset
+                from the start of the line.
+    @return true if the line has an id and at least one group.
+  */
+  bool parse(const char *pline, size_t len, const uint32_t *pdelims, size_t cnt, uint32_t base = 0);
+
+  /// Full line
+  const char *getLine(void) const { return m_pline; };
+  size_t getLineLength(void) const { return m_len; };
+
+  /// Id (OBIS code) part of line
+  const char *getId(void) const { return m_pline; };
+  size_t getIdLength(void) const { return m_lenId; };
+
+  /// Number of (...) groups on the line
+  size_t getGroupCount(void) const { return m_cntGroups; };
+
+  /*!
+    Get value text of a group (text before any '*')
+    @param idx Group index. 0 is the first group, -1 the last.
+    @param pp Set to point at value text.
+    @param plen Set to length of value text.
+    @return true if the group exists.
+  */
+  bool getGroupValue(int idx, const char **pp, size_t *plen) const
+  {
+    const p1group *pg = group(idx);
+    if (nullptr == pg) {
+      return false;
+    }
+    *pp   = m_pline + pg->offset;
+    *plen = pg->lenValue;
+    return true;
+  };
+
+  /*!
+    Get unit text of a group (text after '*')
+    @param idx Group index. 0 is the first group, -1 the last.
+    @param pp Set to point at unit text.
+    @param plen Set to length of unit text. Zero if no unit.
+    @return true if the group exists.
+  */
+  bool getGroupUnit(int idx, const char **pp, size_t *plen) const
+  {
+    const p1group *pg = group(idx);
+    if (nullptr == pg) {
+      return false;
+    }
+    size_t skip = (pg->lenValue < pg->len) ? pg->lenValue + 1 : pg->len;
+    *pp         = m_pline + pg->offset + skip;
+    *plen       = pg->len - skip;
+    return true;
+  };
+
+private:
+  struct p1group {
+    uint32_t offset;   // Offset to first character after '('
+    uint32_t len;      // Length up to ')'
+    uint32_t lenValue; // Length up to '*' or ')'
+  };
+
+  const p1group *group(int idx) const
+  {
+    if (idx < 0) {
+      idx += (int) m_cntGroups;
+    }
+    if ((idx < 0) || ((size_t) idx >= m_cntGroups)) {
+      return nullptr;
+    }
+    return &m_groups[idx];
+  };
+
+  const char *m_pline;
+  size_t m_len;
+  size_t m_lenId;
+  size_t m_cntGroups;
+  p1group m_groups[P1_LINE_MAX_GROUPS];
+};
+
+#endif // VSCP_P1LINE_H__INCLUDED_
@@ -0,0 +1,184 @@
+// p1scan.cpp
+//
+// This file is part of the VSCP (https://www.vscp.org)
+//
+// The MIT License (MIT)
+//
+// Copyright © 2000-2024 Ake Hedman, the VSCP Project
+// <akhe@vscp.org>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include "p1scan.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define P1_SCAN_X86
+#include <immintrin.h>
+#endif
+
+typedef size_t (*p1_scan_fn)(const char *pbuf, size_t len, uint32_t *poffsets);
+
+///////////////////////////////////////////////////////////////////////////////
+// scan_scalar
+//
+
+static size_t
+scan_scalar(const char *pbuf, size_t len, uint32_t *poffsets)
+{
+  size_t cnt = 0;
+
+  for (size_t i = 0; i < len; i++) {
+    char c = pbuf[i];
+    if (('\n' == c) || ('(' == c) || ('*' == c) || (')' == c)) {
+      poffsets[cnt++] = (uint32_t) i;
+    }
+  }
+
+  return cnt;
+}
+
+#ifdef P1_SCAN_X86
+
+///////////////////////////////////////////////////////////////////////////////
+// scan_sse2
+//
+
+__attribute__((target("sse2"))) static size_t
+scan_sse2(const char *pbuf, size_t len, uint32_t *poffsets)
+{
+  const __m128i nl    = _mm_set1_epi8('\n');
+  const __m128i open  = _mm_set1_epi8('(');
+  const __m128i star  = _mm_set1_epi8('*');
+  const __m128i close = _mm_set1_epi8(')');
+  size_t cnt          = 0;
+  size_t i            = 0;
+
+  for (; (i + 16) <= len; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *) (pbuf + i));
+    __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, nl), _mm_cmpeq_epi8(v, open)),
+                             _mm_or_si128(_mm_cmpeq_epi8(v, star), _mm_cmpeq_epi8(v, close)));
+    unsigned mask = (unsigned) _mm_movemask_epi8(m);
+    while (mask) {
+      poffsets[cnt++] = (uint32_t) (i + __builtin_ctz(mask));
+      mask &= mask - 1;
+    }
+  }
+
+  size_t rest = scan_scalar(pbuf + i, len - i, poffsets + cnt);
+  for (size_t j = cnt; j < (cnt + rest); j++) {
+    poffsets[j] += (uint32_t) i;
+  }
+
+  return cnt + rest;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// scan_avx2
+//
+
+__attribute__((target("avx2"))) static size_t
+scan_avx2(const char *pbuf, size_t len, uint32_t *poffsets)
+{
+  const __m256i nl    = _mm256_set1_epi8('\n');
+  const __m256i open  = _mm256_set1_epi8('(');
+  const __m256i star  = _mm256_set1_epi8('*');
+  const __m256i close = _mm256_set1_epi8(')');
+  size_t cnt          = 0;
+  size_t i            = 0;
+
+  for (; (i + 32) <= len; i += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i *) (pbuf + i));
+    __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, nl), _mm256_cmpeq_epi8(v, open)),
+                                _mm256_or_si256(_mm256_cmpeq_epi8(v, star), _mm256_cmpeq_epi8(v, close)));
+    uint32_t mask = (uint32_t) _mm256_movemask_epi8(m);
+    while (mask) {
+      poffsets[cnt++] = (uint32_t) (i + __builtin_ctz(mask));
+      mask &= mask - 1;
+    }
+  }
+
+  size_t rest = scan_sse2(pbuf + i, len - i, poffsets + cnt);
+  for (size_t j = cnt; j < (cnt + rest); j++) {
+    poffsets[j] += (uint32_t) i;
+  }
+
+  return cnt + rest;
+}
+
+#endif // P1_SCAN_X86
+
+///////////////////////////////////////////////////////////////////////////////
+// selectKernel
+//
+
+static p1_scan_fn
+selectKernel(const char **pname)
+{
+#ifdef P1_SCAN_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    *pname = "avx2";
+    return scan_avx2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    *pname = "sse2";
+    return scan_sse2;
+  }
+#endif
+  *pname = "scalar";
+  return scan_scalar;
+}
+
+static const char *scan_kernel_name = "scalar";
+
+///////////////////////////////////////////////////////////////////////////////
+// getKernel
+//
+// Kernel is selected on first use
+//
+
+static p1_scan_fn
+getKernel(void)
+{
+  static const p1_scan_fn fn = selectKernel(&scan_kernel_name);
+  return fn;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// p1_scan_delimiters
+//
+
+size_t
+p1_scan_delimiters(const char *pbuf, size_t len, uint32_t *poffsets)
+{
+  return getKernel()(pbuf, len, poffsets);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// p1_scan_kernel
+//
+
+const char *
+p1_scan_kernel(void)
+{
+  getKernel();
+  return scan_kernel_name;
+}
@@ -0,0 +1,55 @@
+// p1scan.h
+//
+// This file is part of the VSCP (https://www.vscp.org)
+//
+// The MIT License (MIT)
+//
+// Copyright © 2000-2024 Ake Hedman, the VSCP Project
+// <akhe@vscp.org>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#if !defined(VSCP_P1SCAN_H__INCLUDED_)
+#define VSCP_P1SCAN_H__INCLUDED_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*!
+  Find the offset of every '\n', '(', '*' and ')' in a buffer in one
+  pass. Uses AVX2 or SSE2 when the CPU has it (checked once at run
+  time) and a plain loop otherwise.
+  @param pbuf Buffer to scan.
+  @param len Number of bytes in buffer.
+  @param poffsets Receives the offsets in increasing order. Must have
+                  room for len entries.
+  @return Number of offsets written.
+*/
+size_t
+p1_scan_delimiters(const char *pbuf, size_t len, uint32_t *poffsets);
+
+/*!
+  Name of the scan kernel in use ("avx2", "sse2" or "scalar")
+*/
+const char *
+p1_scan_kernel(void);
+
+#endif // VSCP_P1SCAN_H__INCLUDED_
@@ -0,0 +1,265 @@
+// p1telegram.cpp
+//
+// This file is part of the VSCP (https://www.vscp.org)
+//
+// The MIT License (MIT)
+//
+// Copyright © 2000-2024 Ake Hedman, the VSCP Project
+// <akhe@vscp.org>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <string.h>
+
+#include "p1scan.h"
+#include "p1telegram.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// CRC16 tables
+//
+// Slice-by-8 tables for CRC-16/ARC (reflected polynom 0xA001) built
+// at compile time. Table 0 is the ordinary byte table, table n is the
+// CRC of a byte followed by n zero bytes.
+//
+
+namespace {
+
+struct crc16_tables {
+  uint16_t t[8][256];
+
+  constexpr crc16_tables()
+    : t()
+  {
+    for (int i = 0; i < 256; i++) {
+      uint16_t crc = (uint16_t) i;
+      for (int j = 0; j < 8; j++) {
+        crc = (crc & 1) ? (uint16_t) ((crc >> 1) ^ 0xA001) : (uint16_t) (crc >> 1);
+      }
+      t[0][i] = crc;
+    }
+
+    for (int n = 1; n < 8; n++) {
+      for (int i = 0; i < 256; i++) {
+        t[n][i] = (uint16_t) ((t[n - 1][i] >> 8) ^ t[0][t[n - 1][i] & 0xff]);
+      }
+    }
+  }
+};
+
+constexpr crc16_tables crc16_table;
+
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+// CTOR
+//
+
+CP1Telegram::CP1Telegram(size_t maxsize)
+{
+  m_maxsize = maxsize;
+  m_pbuf    = new char[m_maxsize];
+  m_pdelims = new uint32_t[m_maxsize];
+  m_lines.reserve(64);
+
+  m_bCrcCheck = true;
+
+  m_cntTelegrams  = 0;
+  m_cntCrcErrors  = 0;
+  m_cntOverflows  = 0;
+  m_cntStrayLines = 0;
+
+  reset();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// DTOR
+//
+
+CP1Telegram::~CP1Telegram()
+{
+  delete[] m_pbuf;
+  delete[] m_pdelims;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// reset
+//
+
+void
+CP1Telegram::reset(void)
+{
+  m_size = 0;
+  m_lines.clear();
+  m_bInTelegram = false;
+  m_bHasCrc     = false;
+  m_crc         = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// crc16
+//
+
+uint16_t
+CP1Telegram::crc16(uint16_t crc, const uint8_t *pdata, size_t len)
+{
+  const uint16_t(*t)[256] = crc16_table.t;
+
+  while (len >= 8) {
+    crc ^= (uint16_t) (pdata[0] | (pdata[1] << 8));
+    crc = t[7][crc & 0xff] ^ t[6][crc >> 8] ^ t[5][pdata[2]] ^ t[4][pdata[3]] ^
+          t[3][pdata[4]] ^ t[2][pdata[5]] ^ t[1][pdata[6]] ^ t[0][pdata[7]];
+    pdata += 8;
+    len -= 8;
+  }
+
+  while (len--) {
+    crc = (crc >> 8) ^ t[0][(crc ^ *pdata++) & 0xff];
+  }
+
+  return crc;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// parseCrc
+//
+
+bool
+CP1Telegram::parseCrc(const char *pline, size_t len, uint16_t *pcrc)
+{
+  uint16_t crc = 0;
+
+  if (len < 5) {
+    return false;
+  }
+
+  for (int i = 1; i < 5; i++) {
+    char c = pline[i];
+    crc <<= 4;
+    if ((c >= '0') && (c <= '9')) {
+      crc |= (c - '0');
+    }
+    else if ((c >= 'A') && (c <= 'F')) {
+      crc |= (c - 'A' + 10);
+    }
+    else if ((c >= 'a') && (c <= 'f')) {
+      crc |= (c - 'a' + 10);
+    }
+    else {
+      return false;
+    }
+  }
+
+  *pcrc = crc;
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// addLine
+//
+
+int
+CP1Telegram::addLine(const char *pline, size_t len)
+{
+  if (!len) {
+    return m_bInTelegram ? P1_TELEGRAM_INCOMPLETE : P1_TELEGRAM_NO_START;
+  }
+
+  // A header line always starts a new telegram. A telegram that was
+  // not finished is dropped.
+  if ('/' == pline[0]) {
+    reset();
+    m_bInTelegram = true;
+  }
+  else if (!m_bInTelegram) {
+    m_cntStrayLines++;
+    return P1_TELEGRAM_NO_START;
+  }
+
+  if ((m_size + len) > m_maxsize) {
+    m_cntOverflows++;
+    reset();
+    return P1_TELEGRAM_OVERFLOW;
+  }
+
+  if (('(' == pline[0]) && (m_lines.size() > 1)) {
+    // Continuation of the previous line. Older meters (DSMR 2.2) put
+    // the gas value on a line of its own. Join it with the line before
+    // so it can be handled as one line.
+    p1line &prev = m_lines.back();
+    while (prev.len && (('\r' == m_pbuf[m_size - 1]) || ('\n' == m_pbuf[m_size - 1]))) {
+      prev.len--;
+      m_size--;
+    }
+    prev.len += (uint32_t) len;
+  }
+  else {
+    p1line line;
+    line.offset     = (uint32_t) m_size;
+    line.len        = (uint32_t) len;
+    line.firstDelim = 0;
+    line.cntDelims  = 0;
+    m_lines.push_back(line);
+  }
+
+  memcpy(m_pbuf + m_size, pline, len);
+  m_size += len;
+
+  if ('!' != pline[0]) {
+    m_crc = crc16(m_crc, (const uint8_t *) pline, len);
+    return P1_TELEGRAM_INCOMPLETE;
+  }
+
+  // End of telegram. The '!' is part of the CRC
+  m_bInTelegram = false;
+  m_crc         = crc16(m_crc, (const uint8_t *) pline, 1);
+
+  uint16_t crc;
+  m_bHasCrc = parseCrc(pline, len, &crc);
+  if (m_bHasCrc && m_bCrcCheck && (crc != m_crc)) {
+    m_cntCrcErrors++;
+    return P1_TELEGRAM_CRC_ERROR;
+  }
+
+  buildIndex();
+
+  m_cntTelegrams++;
+  return P1_TELEGRAM_COMPLETE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// buildIndex
+//
+
+void
+CP1Telegram::buildIndex(void)
+{
+  size_t cnt = p1_scan_delimiters(m_pbuf, m_size, m_pdelims);
+  size_t k   = 0;
+
+  for (auto &line : m_lines) {
+    uint32_t end    = line.offset + line.len;
+    line.firstDelim = (uint32_t) k;
+    while ((k < cnt) && (m_pdelims[k] < end)) {
+      k++;
+    }
+    line.cntDelims = (uint32_t) k - line.firstDelim;
+  }
+}
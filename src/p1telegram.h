@@ -0,0 +1,231 @@
+// p1telegram.h
+//
+// This file is part of the VSCP (https://www.vscp.org)
+//
+// The MIT License (MIT)
+//
+// Copyright © 2000-2024 Ake Hedman, the VSCP Project
+// <akhe@vscp.org>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#if !defined(VSCP_P1TELEGRAM_H__INCLUDED_)
+#define VSCP_P1TELEGRAM_H__INCLUDED_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+// Result codes from CP1Telegram::addLine
+#define P1_TELEGRAM_INCOMPLETE  0 // Line added, telegram not complete yet
+#define P1_TELEGRAM_COMPLETE    1 // Telegram complete and valid
+#define P1_TELEGRAM_CRC_ERROR   2 // Telegram complete but CRC is wrong
+#define P1_TELEGRAM_OVERFLOW    3 // Telegram too large, thrown away
+#define P1_TELEGRAM_NO_START    4 // Line outside of a telegram, ignored
+
+/*!
+  Default max size for a telegram
+*/
+#define P1_TELEGRAM_DEFAULT_MAX_SIZE 8192
+
+/*!
+  Collects the lines of one P1 telegram.
+
+  A telegram starts with a line beginning with '/' and ends with a
+  line beginning with '!' that is followed by the CRC16 (four hex
+  digits) of everything from the '/' up to and including the '!'.
+  The CRC is calculated on the fly as lines are added so a complete
+  telegram is checked without a second pass over the data. Older
+  meters (DSMR < 4) do not send a CRC. Such telegrams are accepted
+  as they are.
+
+  When a telegram is complete all delimiters in it are found in one
+  (vectorised) pass, see p1scan.h, so lines can be split without
+  searching them again.
+
+  Lines are stored back to back in one buffer that is allocated once.
+  A line starting with '(' continues the line before it (DSMR 2.2 gas
+  readings) and is joined with it.
+*/
+
+class CP1Telegram {
+
+public:
+  /*!
+    CTOR
+    @param maxsize Max number of bytes in a telegram
+  */
+  CP1Telegram(size_t maxsize = P1_TELEGRAM_DEFAULT_MAX_SIZE);
+
+  /// DTOR
+  ~CP1Telegram();
+
+  /*!
+    Add a line to the telegram
+    @param pline Pointer to line including line end.
+    @param len Length of line.
+    @return One of the P1_TELEGRAM_xxx codes.
+  */
+  int addLine(const char *pline, size_t len);
+
+  /// Start over with an empty telegram
+  void reset(void);
+
+  /// Number of lines in a complete telegram
+  size_t getLineCount(void) const { return m_lines.size(); };
+
+  /*!
+    Get line
+    @param idx Line index (0 is the '/' header line)
+    @param plen Set to length of line including line end.
+    @return Pointer to line.
+  */
+  const char *getLine(size_t idx, size_t *plen) const
+  {
+    *plen = m_lines[idx].len;
+    return m_pbuf + m_lines[idx].offset;
+  };
+
+  /*!
+    Get delimiter index for a line. Only valid for a complete
+    telegram.
+    @param idx Line index
+    @param pcnt Set to number of delimiters on the line
+    @return Pointer to offsets (from start of telegram data) of all
+            '\n', '(', '*' and ')' on the line.
+  */
+  const uint32_t *getLineDelimiters(size_t idx, size_t *pcnt) const
+  {
+    *pcnt = m_lines[idx].cntDelims;
+    return m_pdelims + m_lines[idx].firstDelim;
+  };
+
+  /// Offset of a line from the start of telegram data
+  uint32_t getLineOffset(size_t idx) const { return m_lines[idx].offset; };
+
+  /// Pointer to telegram data (continuation lines joined)
+  const char *getData(void) const { return m_pbuf; };
+
+  /// Size of telegram data
+  size_t getSize(void) const { return m_size; };
+
+  /// True if the telegram carried a CRC
+  bool hasCrc(void) const { return m_bHasCrc; };
+
+  /*!
+    Enable/disable CRC check. With the check disabled telegrams with
+    a wrong CRC are accepted.
+  */
+  void setCrcCheck(bool bCheck = true) { m_bCrcCheck = bCheck; };
+  bool isCrcCheck(void) const { return m_bCrcCheck; };
+
+  // Statistics
+  uint64_t getTelegramCount(void) const { return m_cntTelegrams; };
+  uint64_t getCrcErrorCount(void) const { return m_cntCrcErrors; };
+  uint64_t getOverflowCount(void) const { return m_cntOverflows; };
+  uint64_t getStrayLineCount(void) const { return m_cntStrayLines; };
+
+  /*!
+    Calculate DSMR CRC16 (CRC-16/ARC, polynom 0xA001 reflected,
+    initial value 0) using a slice-by-8 table.
+    @param crc CRC so far (0 to start)
+    @param pdata Pointer to data
+    @param len Number of bytes
+    @return Updated CRC
+  */
+  static uint16_t crc16(uint16_t crc, const uint8_t *pdata, size_t len);
+
+private:
+  struct p1line {
+    uint32_t offset;
+    uint32_t len;
+    uint32_t firstDelim; // Index in m_pdelims of first delimiter
+    uint32_t cntDelims;  // Number of delimiters on line
+  };
+
+  /*!
+    Find all delimiters in the telegram in one pass and give each
+    line its part of the result.
+  */
+  void buildIndex(void);
+
+  /*!
+    Get CRC value from '!' line
+    @param pline Pointer to line (starting with '!')
+    @param len Length of line
+    @param pcrc Set to CRC value
+    @return true if there was a CRC on the line
+  */
+  static bool parseCrc(const char *pline, size_t len, uint16_t *pcrc);
+
+  /*!
+    Telegram data
+  */
+  char *m_pbuf;
+
+  /*!
+    Delimiter offsets for the telegram (room for m_maxsize)
+  */
+  uint32_t *m_pdelims;
+
+  /*!
+    Number of bytes in m_pbuf
+  */
+  size_t m_size;
+
+  /*!
+    Max number of bytes in m_pbuf
+  */
+  size_t m_maxsize;
+
+  /*!
+    Lines in the telegram
+  */
+  std::vector<p1line> m_lines;
+
+  /*!
+    True when a '/' has been seen and the '!' has not
+  */
+  bool m_bInTelegram;
+
+  /*!
+    True if last completed telegram had a CRC
+  */
+  bool m_bHasCrc;
+
+  /*!
+    True if CRC should be checked
+  */
+  bool m_bCrcCheck;
+
+  /*!
+    Running CRC
+  */
+  uint16_t m_crc;
+
+  // Statistics
+  uint64_t m_cntTelegrams;
+  uint64_t m_cntCrcErrors;
+  uint64_t m_cntOverflows;
+  uint64_t m_cntStrayLines;
+};
+
+#endif // VSCP_P1TELEGRAM_H__INCLUDED_
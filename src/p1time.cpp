@@ -0,0 +1,121 @@
+// p1time.cpp
+//
+// This file is part of the VSCP (https://www.vscp.org)
+//
+// The MIT License (MIT)
+//
+// Copyright © 2000-2024 Ake Hedman, the VSCP Project
+// <akhe@vscp.org>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include "p1time.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// p1_days_from_civil
+//
+// From Howard Hinnant's date algorithms
+//
+
+int64_t
+p1_days_from_civil(int y, unsigned m, unsigned d)
+{
+  y -= (m <= 2);
+  const int era      = (y >= 0 ? y : y - 399) / 400;
+  const unsigned yoe = (unsigned) (y - era * 400);                     // [0, 399]
+  const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1; // [0, 365]
+  const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;          // [0, 146096]
+  return (int64_t) era * 146097 + (int64_t) doe - 719468;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// p1_datetime_from_epoch
+//
+
+void
+p1_datetime_from_epoch(int64_t t, p1_datetime *pdt)
+{
+  int64_t days = t / 86400;
+  int64_t secs = t % 86400;
+  if (secs < 0) {
+    secs += 86400;
+    days--;
+  }
+
+  pdt->hour   = (uint8_t) (secs / 3600);
+  pdt->minute = (uint8_t) ((secs % 3600) / 60);
+  pdt->second = (uint8_t) (secs % 60);
+
+  days += 719468;
+  const int64_t era  = (days >= 0 ? days : days - 146096) / 146097;
+  const unsigned doe = (unsigned) (days - era * 146097);                    // [0, 146096]
+  const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365; // [0, 399]
+  const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);              // [0, 365]
+  const unsigned mp  = (5 * doy + 2) / 153;                                  // [0, 11]
+  const unsigned d   = doy - (153 * mp + 2) / 5 + 1;                         // [1, 31]
+  const unsigned m   = mp < 10 ? mp + 3 : mp - 9;                            // [1, 12]
+
+  pdt->year  = (uint16_t) ((int64_t) yoe + era * 400 + (m <= 2));
+  pdt->month = (uint8_t) m;
+  pdt->day   = (uint8_t) d;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// p1_parse_timestamp
+//
+
+bool
+p1_parse_timestamp(const char *p, size_t len, int utcOffset, int64_t *pt)
+{
+  unsigned v[6];
+
+  if ((len < 12) || (len > 13)) {
+    return false;
+  }
+
+  for (int i = 0; i < 6; i++) {
+    unsigned hi = (unsigned) (p[2 * i] - '0');
+    unsigned lo = (unsigned) (p[2 * i + 1] - '0');
+    if ((hi > 9) || (lo > 9)) {
+      return false;
+    }
+    v[i] = hi * 10 + lo;
+  }
+
+  // Month, day, hour, minute, second (leap second allowed)
+  if ((v[1] < 1) || (v[1] > 12) || (v[2] < 1) || (v[2] > 31) || (v[3] > 23) || (v[4] > 59) || (v[5] > 60)) {
+    return false;
+  }
+
+  int offset = utcOffset;
+  if (13 == len) {
+    if ('S' == p[12]) {
+      offset += 60;
+    }
+    else if ('W' != p[12]) {
+      return false;
+    }
+  }
+
+  *pt = p1_days_from_civil(2000 + (int) v[0], v[1], v[2]) * 86400 + v[3] * 3600 + v[4] * 60 + v[5] -
+        (int64_t) offset * 60;
+  return true;
+}
@@ -0,0 +1,81 @@
+// p1time.h
+//
+// This file is part of the VSCP (https://www.vscp.org)
+//
+// The MIT License (MIT)
+//
+// Copyright © 2000-2024 Ake Hedman, the VSCP Project
+// <akhe@vscp.org>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#if !defined(VSCP_P1TIME_H__INCLUDED_)
+#define VSCP_P1TIME_H__INCLUDED_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*!
+  Broken down UTC time
+*/
+struct p1_datetime {
+  uint16_t year;
+  uint8_t month;
+  uint8_t day;
+  uint8_t hour;
+  uint8_t minute;
+  uint8_t second;
+};
+
+/*!
+  Number of days from 1970-01-01 to a date (proleptic Gregorian)
+  @param y Year
+  @param m Month 1-12
+  @param d Day 1-31
+  @return Days since epoch (negative before 1970)
+*/
+int64_t
+p1_days_from_civil(int y, unsigned m, unsigned d);
+
+/*!
+  Convert seconds since epoch to broken down UTC time
+  @param t Seconds since 1970-01-01 00:00:00 UTC
+  @param pdt Set to broken down time
+*/
+void
+p1_datetime_from_epoch(int64_t t, p1_datetime *pdt);
+
+/*!
+  Parse a P1 timestamp YYMMDDhhmmssX where X is 'W' for standard
+  (winter) time and 'S' for daylight saving (summer) time. A
+  timestamp without the letter is taken as standard time. The
+  meter sends local time, utcOffset is used to get UTC.
+  @param p Pointer to timestamp text.
+  @param len Length of text.
+  @param utcOffset Offset from UTC in minutes for standard time
+                   (60 for CET). One hour more is used for 'S'.
+  @param pt Set to seconds since epoch (UTC).
+  @return true on success, false if not a valid timestamp.
+*/
+bool
+p1_parse_timestamp(const char *p, size_t len, int utcOffset, int64_t *pt);
+
+#endif // VSCP_P1TIME_H__INCLUDED_
@@ -0,0 +1,206 @@
+// ringbuffer.cpp
+//
+// This file is part of the VSCP (https://www.vscp.org)
+//
+// The MIT License (MIT)
+//
+// Copyright © 2000-2024 Ake Hedman, the VSCP Project
+// <akhe@vscp.org>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "ringbuffer.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// CTOR
+//
+
+CRingBuffer::CRingBuffer(size_t size)
+{
+  size_t sz = 16;
+  while (sz < size) {
+    sz <<= 1;
+  }
+
+  m_pbuf = new char[sz];
+  m_mask = sz - 1;
+  m_head = 0;
+  m_tail = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// DTOR
+//
+
+CRingBuffer::~CRingBuffer()
+{
+  delete[] m_pbuf;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// readFrom
+//
+
+ssize_t
+CRingBuffer::readFrom(int fd)
+{
+  struct iovec iov[2];
+  size_t free = space();
+
+  if (!free) {
+    return 0;
+  }
+
+  // Free space may wrap around the end of the buffer
+  size_t pos   = m_head & m_mask;
+  size_t first = capacity() - pos;
+  if (first > free) {
+    first = free;
+  }
+
+  iov[0].iov_base = m_pbuf + pos;
+  iov[0].iov_len  = first;
+  iov[1].iov_base = m_pbuf;
+  iov[1].iov_len  = free - first;
+
+  ssize_t rv = ::readv(fd, iov, iov[1].iov_len ? 2 : 1);
+  if (rv > 0) {
+    m_head += rv;
+  }
+
+  return rv;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// write
+//
+
+size_t
+CRingBuffer::write(const char *pbuf, size_t len)
+{
+  if (len > space()) {
+    len = space();
+  }
+
+  size_t pos   = m_head & m_mask;
+  size_t first = capacity() - pos;
+  if (first > len) {
+    first = len;
+  }
+
+  memcpy(m_pbuf + pos, pbuf, first);
+  memcpy(m_pbuf, pbuf + first, len - first);
+  m_head += len;
+
+  return len;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// find
+//
+
+size_t
+CRingBuffer::find(char c, size_t from) const
+{
+  size_t cnt = size();
+  if (from >= cnt) {
+    return npos;
+  }
+
+  // Search in at most two contiguous parts with memchr
+  size_t pos   = (m_tail + from) & m_mask;
+  size_t first = capacity() - pos;
+  if (first > (cnt - from)) {
+    first = cnt - from;
+  }
+
+  const char *p = (const char *) memchr(m_pbuf + pos, c, first);
+  if (nullptr != p) {
+    return from + (p - (m_pbuf + pos));
+  }
+
+  size_t rest = cnt - from - first;
+  if (rest) {
+    p = (const char *) memchr(m_pbuf, c, rest);
+    if (nullptr != p) {
+      return from + first + (p - m_pbuf);
+    }
+  }
+
+  return npos;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// peek
+//
+
+size_t
+CRingBuffer::peek(char *pbuf, size_t len) const
+{
+  if (len > size()) {
+    len = size();
+  }
+
+  size_t pos   = m_tail & m_mask;
+  size_t first = capacity() - pos;
+  if (first > len) {
+    first = len;
+  }
+
+  memcpy(pbuf, m_pbuf + pos, first);
+  memcpy(pbuf + first, m_pbuf, len - first);
+
+  return len;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// consume
+//
+
+void
+CRingBuffer::consume(size_t len)
+{
+  if (len > size()) {
+    len = size();
+  }
+
+  m_tail += len;
+
+  // Start over at the beginning when empty. This keeps the next
+  // read contiguous in memory.
+  if (m_tail == m_head) {
+    m_head = m_tail = 0;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// contiguous
+//
+
+size_t
+CRingBuffer::contiguous(void) const
+{
+  size_t first = capacity() - (m_tail & m_mask);
+  return (first < size()) ? first : size();
+}
@@ -0,0 +1,159 @@
+// ringbuffer.h
+//
+// This file is part of the VSCP (https://www.vscp.org)
+//
+// The MIT License (MIT)
+//
+// Copyright © 2000-2024 Ake Hedman, the VSCP Project
+// <akhe@vscp.org>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#if !defined(VSCP_RINGBUFFER_H__INCLUDED_)
+#define VSCP_RINGBUFFER_H__INCLUDED_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/*!
+  Byte ring buffer for serial input.
+
+  Everything the serial port has available is read with one
+  readv() call straight into the free space of the buffer. Lines
+  are then picked out of the buffer by the caller. The buffer is
+  allocated once and reused for the lifetime of the driver.
+*/
+
+class CRingBuffer {
+
+public:
+  /// Returned by find when nothing is found
+  static const size_t npos = (size_t) -1;
+
+  /*!
+    CTOR
+    @param size Wanted size in bytes. Rounded up to a power of two.
+  */
+  CRingBuffer(size_t size = 4096);
+
+  /// DTOR
+  ~CRingBuffer();
+
+  /*!
+    Read all that is available (up to the free space) from a file
+    descriptor in one system call.
+    @param fd File descriptor to read from.
+    @return Number of bytes read, 0 if buffer is full or nothing
+            was read and -1 on error (errno set).
+  */
+  ssize_t readFrom(int fd);
+
+  /*!
+    Append data to the buffer
+    @param pbuf Pointer to data to append.
+    @param len Number of bytes to append.
+    @return Number of bytes actually appended.
+  */
+  size_t write(const char *pbuf, size_t len);
+
+  /*!
+    Find first occurrence of a byte
+    @param c Byte to search for.
+    @param from Offset from the start of the buffered data to
+                start the search at.
+    @return Offset from the start of buffered data or npos if not
+            found.
+  */
+  size_t find(char c, size_t from = 0) const;
+
+  /*!
+    Copy data from the start of the buffer without consuming it
+    @param pbuf Buffer that will receive the data.
+    @param len Number of bytes to copy.
+    @return Number of bytes copied.
+  */
+  size_t peek(char *pbuf, size_t len) const;
+
+  /*!
+    Remove bytes from the start of the buffer
+    @param len Number of bytes to remove.
+  */
+  void consume(size_t len);
+
+  /*!
+    Get byte at offset from start of buffered data.
+    No range check is done.
+  */
+  char at(size_t offset) const { return m_pbuf[(m_tail + offset) & m_mask]; };
+
+  /*!
+    Pointer to the first buffered byte
+  */
+  const char *front(void) const { return m_pbuf + (m_tail & m_mask); };
+
+  /*!
+    Number of buffered bytes that are contiguous in memory
+    starting at front().
+  */
+  size_t contiguous(void) const;
+
+  /// Empty the buffer
+  void clear(void) { m_head = m_tail = 0; };
+
+  /// Number of bytes in the buffer
+  size_t size(void) const { return m_head - m_tail; };
+
+  /// Total number of bytes the buffer can hold
+  size_t capacity(void) const { return m_mask + 1; };
+
+  /// Free space in bytes
+  size_t space(void) const { return capacity() - size(); };
+
+  bool isEmpty(void) const { return (m_head == m_tail); };
+  bool isFull(void) const { return (0 == space()); };
+
+private:
+  // Disable copy
+  CRingBuffer(const CRingBuffer &);
+  CRingBuffer &operator=(const CRingBuffer &);
+
+  /*!
+    Buffer storage
+  */
+  char *m_pbuf;
+
+  /*!
+    Size of buffer minus one (size is a power of two)
+  */
+  size_t m_mask;
+
+  /*!
+    Write position. Free running, wrapped with m_mask on use.
+  */
+  size_t m_head;
+
+  /*!
+    Read position. Free running, wrapped with m_mask on use.
+  */
+  size_t m_tail;
+};
+
+#endif // VSCP_RINGBUFFER_H__INCLUDED_
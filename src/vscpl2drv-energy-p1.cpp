@@ -36,6 +36,7 @@
 #include <semaphore.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include "version.h"
 
@@ -245,37 +246,34 @@ VSCPClose(long handle)
 extern "C" int
 VSCPWrite(long handle, const vscpEvent* pEvent, unsigned long timeout)
 {
+    // Check pointer
+    if (NULL == pEvent) {
+        return CANAL_ERROR_PARAMETER;
+    }
+
     CEnergyP1* pdrvObj = getDriverObject(handle);
     if (NULL == pdrvObj) {
         return CANAL_ERROR_MEMORY;
     }
 
-    //pdrvObj->addEvent2SendQueue(pEvent);
-    //pdrvObj->sendEventAllClients(pEvent);
+    // Handled by the worker thread, never waits
+    if (!pdrvObj->addEvent2SendQueue(pEvent)) {
+        return CANAL_ERROR_FIFO_FULL;
+    }
 
     return CANAL_ERROR_SUCCESS;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-//  VSCPRead
+// waitReceiveQueue
+//
+// Wait for events on the receive queue
 //
 
-extern "C" int
-VSCPRead(long handle, vscpEvent* pEvent, unsigned long timeout)
+static int
+waitReceiveQueue(CEnergyP1* pdrvObj, unsigned long timeout)
 {
-    int rv = 0;
-
-    // Check pointer
-    if (NULL == pEvent) {
-        return CANAL_ERROR_PARAMETER;
-    }
-
-    CEnergyP1* pdrvObj = getDriverObject(handle);
-    if (NULL == pdrvObj) {
-        return CANAL_ERROR_MEMORY;
-    }
-
-    if (-1 == (rv = vscp_sem_wait(&pdrvObj->m_semReceiveQueue, timeout))) {       
+    if (-1 == vscp_sem_wait(&pdrvObj->m_semReceiveQueue, timeout)) {       
         if (ETIMEDOUT == errno) {
             return CANAL_ERROR_TIMEOUT;
         } else if (EINTR == errno) {
@@ -304,20 +302,143 @@ VSCPRead(long handle, vscpEvent* pEvent, unsigned long timeout)
         }
     }
 
-    pthread_mutex_lock(&pdrvObj->m_mutexReceiveQueue);
-    vscpEvent* pLocalEvent = pdrvObj->m_receiveList.front();
-    pdrvObj->m_receiveList.pop_front();
-    pthread_mutex_unlock(&pdrvObj->m_mutexReceiveQueue);
-    if (NULL == pLocalEvent) {
+    return CANAL_ERROR_SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// remainingTimeout
+//
+// Milliseconds left of timeout counted from start, zero if it has
+// passed
+//
+
+static unsigned long
+remainingTimeout(const struct timespec& start, unsigned long timeout)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    uint64_t elapsed = (uint64_t) (now.tv_sec - start.tv_sec) * 1000 +
+                       (now.tv_nsec - start.tv_nsec) / 1000000;
+    return (elapsed >= timeout) ? 0 : (unsigned long) (timeout - elapsed);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  VSCPRead
+//
+
+extern "C" int
+VSCPRead(long handle, vscpEvent* pEvent, unsigned long timeout)
+{
+    int rv = 0;
+
+    // Check pointer
+    if (NULL == pEvent) {
+        return CANAL_ERROR_PARAMETER;
+    }
+
+    CEnergyP1* pdrvObj = getDriverObject(handle);
+    if (NULL == pdrvObj) {
         return CANAL_ERROR_MEMORY;
     }
 
+    // Events of a telegram are signalled once, read what is there
+    // before waiting. A wakeup can find the queue empty, wait again
+    // for what is left of the timeout.
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    vscpEvent* pLocalEvent;
+    unsigned long wait = timeout;
+    while (NULL == (pLocalEvent = pdrvObj->popReceiveQueue())) {
+        if (CANAL_ERROR_SUCCESS != (rv = waitReceiveQueue(pdrvObj, wait))) {
+            return rv;
+        }
+        if (NULL != (pLocalEvent = pdrvObj->popReceiveQueue())) {
+            break;
+        }
+        if (0 == (wait = remainingTimeout(start, timeout))) {
+            return CANAL_ERROR_TIMEOUT;
+        }
+    }
+
     vscp_copyEvent(pEvent, pLocalEvent);
-    vscp_deleteEvent_v2(&pLocalEvent);
+    pdrvObj->m_eventPool.releaseReader(pLocalEvent);
+
+    return CANAL_ERROR_SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  VSCPReadMany
+//
+// Read up to max events into an array supplied by the caller. If there
+// are no events it waits until at least one arrives, at most timeout
+// milliseconds in total. Event data is copied into the array so nothing
+// is allocated and nothing needs to be freed by the caller.
+//
+
+extern "C" int
+VSCPReadMany(long handle,
+             vscpEventEx* pex,
+             unsigned long max,
+             unsigned long* pcnt,
+             unsigned long timeout)
+{
+    int rv = 0;
+
+    // Check pointers
+    if ((NULL == pex) || (NULL == pcnt) || !max) {
+        return CANAL_ERROR_PARAMETER;
+    }
+
+    *pcnt = 0;
+
+    CEnergyP1* pdrvObj = getDriverObject(handle);
+    if (NULL == pdrvObj) {
+        return CANAL_ERROR_MEMORY;
+    }
+
+    // A wakeup can find the queue empty, wait again for what is left
+    // of the timeout
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    unsigned long wait = timeout;
+    while (0 == (*pcnt = pdrvObj->popReceiveQueue(pex, max))) {
+        if (CANAL_ERROR_SUCCESS != (rv = waitReceiveQueue(pdrvObj, wait))) {
+            return rv;
+        }
+        if (0 != (*pcnt = pdrvObj->popReceiveQueue(pex, max))) {
+            break;
+        }
+        if (0 == (wait = remainingTimeout(start, timeout))) {
+            return CANAL_ERROR_TIMEOUT;
+        }
+    }
 
     return CANAL_ERROR_SUCCESS;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//  VSCPGetReceiveFd
+//
+// Descriptor that is readable when there are events to read. Hosts can
+// poll it together with descriptors of other drivers and then read
+// with VSCPRead/VSCPReadMany without blocking. The host must not read
+// from or close the descriptor.
+//
+
+extern "C" int
+VSCPGetReceiveFd(long handle)
+{
+    CEnergyP1* pdrvObj = getDriverObject(handle);
+    if (NULL == pdrvObj) {
+        return -1;
+    }
+
+    return pdrvObj->m_fdReceive;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // VSCPGetVersion
 //
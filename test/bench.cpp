@@ -0,0 +1,375 @@
+// bench.cpp
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version
+// 2 of the License, or (at your option) any later version.
+//
+// This file is part of the VSCP (http://www.vscp.org)
+//
+// Copyright (C) 2000-2024 Ake Hedman,
+// the VSCP Project, <akhe@vscp.org>
+//
+// This file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this file see the file COPYING.  If not, write to
+// the Free Software Foundation, 59 Temple Place - Suite 330,
+// Boston, MA 02111-1307, USA.
+//
+// Micro benchmarks for the P1 parser and event pipeline.
+//
+// Usage: bench [passes] [file ...]
+//
+// Default files are the sample telegrams in ../python. Lines in the
+// files end with LF only (CR lost on capture), CR is added back so
+// the telegram CRC can be checked as for a real meter.
+//
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <vscp.h>
+#include <vscphelper.h>
+
+#include <nlohmann/json.hpp> // Needs C++11  -std=c++11
+
+#include "spdlog/spdlog.h"
+
+#include "../src/energy-p1-obj.h"
+#include "../src/p1item.h"
+#include "../src/p1line.h"
+
+// Bytes fed to the framer per call (one serial read)
+#define BENCH_CHUNK_SIZE 64
+
+// Default number of passes over the input
+#define BENCH_DEFAULT_PASSES 2000
+
+///////////////////////////////////////////////////////////////////////////////
+// Allocation counting
+//
+// Counts calls to operator new. Memory allocated with malloc from C
+// code (event data) is not counted.
+//
+
+static uint64_t g_cntAlloc = 0;
+
+void *
+operator new(size_t size)
+{
+  g_cntAlloc++;
+  void *p = malloc(size ? size : 1);
+  if (nullptr == p) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void
+operator delete(void *p) noexcept
+{
+  free(p);
+}
+
+void
+operator delete(void *p, size_t) noexcept
+{
+  free(p);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// nsNow
+//
+
+static uint64_t
+nsNow(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// loadFile
+//
+// Read a capture file and make sure all lines end with CR LF
+//
+
+static bool
+loadFile(const std::string &path, std::string &data)
+{
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    fprintf(stderr, "Unable to open %s\n", path.c_str());
+    return false;
+  }
+
+  std::stringstream ss;
+  ss << in.rdbuf();
+  std::string raw = ss.str();
+
+  for (size_t i = 0; i < raw.length(); i++) {
+    if (('\n' == raw[i]) && ((0 == i) || ('\r' != raw[i - 1]))) {
+      data += '\r';
+    }
+    data += raw[i];
+  }
+
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// drainReceiveQueue
+//
+// Take all events off the receive queue as the host would
+// @return Number of events
+//
+
+static size_t
+drainReceiveQueue(CEnergyP1 &p1)
+{
+  size_t cnt = 0;
+
+  vscpEvent *pev;
+  while (nullptr != (pev = p1.popReceiveQueue())) {
+    p1.m_eventPool.release(pev);
+    cnt++;
+  }
+
+  return cnt;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// benchLines
+//
+// doWork for every data line
+//
+
+static void
+benchLines(CEnergyP1 &p1, const std::vector<std::string> &lines, int passes)
+{
+  uint64_t cntEvents = 0;
+  uint64_t start     = nsNow();
+
+  for (int i = 0; i < passes; i++) {
+    for (auto const &line : lines) {
+      p1.doWork(line.data(), line.length());
+    }
+    cntEvents += drainReceiveQueue(p1);
+  }
+
+  uint64_t ns = nsNow() - start;
+  printf("doWork:          %10.1f ns/line      (%zu lines, %llu events)\n",
+         (double) ns / ((double) passes * lines.size()),
+         lines.size(),
+         (unsigned long long) cntEvents);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// benchUnit
+//
+// Unit lookup for every line that has an item
+//
+
+static void
+benchUnit(CEnergyP1 &p1, const std::vector<std::string> &lines, int passes)
+{
+  std::vector<CP1Line> parsed;
+  std::vector<CP1Item *> items;
+
+  for (auto const &str : lines) {
+    CP1Line line;
+    uint64_t key;
+    CP1Item *const *ppItems;
+    if (!line.parse(str.data(), str.length()) ||
+        (line.getIdLength() != obis_parse(line.getId(), line.getIdLength(), &key))) {
+      continue;
+    }
+    size_t cnt = p1.m_obisMap.find(key, &ppItems);
+    for (size_t i = 0; i < cnt; i++) {
+      parsed.push_back(line);
+      items.push_back(ppItems[i]);
+    }
+  }
+
+  if (!items.size()) {
+    printf("getUnit:         no items match the input\n");
+    return;
+  }
+
+  int sum        = 0;
+  uint64_t start = nsNow();
+
+  for (int i = 0; i < passes; i++) {
+    for (size_t j = 0; j < items.size(); j++) {
+      sum += items[j]->getUnit(parsed[j]);
+    }
+  }
+
+  uint64_t ns = nsNow() - start;
+  printf("getUnit:         %10.1f ns/lookup    (%zu items, sum %d)\n",
+         (double) ns / ((double) passes * items.size()),
+         items.size(),
+         sum);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// benchEvent
+//
+// Build a measurement event, put it on the receive queue and take it
+// off again
+//
+
+static void
+benchEvent(CEnergyP1 &p1, int passes)
+{
+  const int cnt  = passes * 32;
+  uint64_t start = nsNow();
+
+  for (int i = 0; i < cnt; i++) {
+    vscpEventEx ex;
+    memset(&ex, 0, sizeof(ex));
+    vscp_makeLevel2StringMeasurementEventEx(&ex, 13, 40649.246 + i, 1, 0, 0, 0);
+    ex.vscp_class = VSCP_CLASS2_MEASUREMENT_STR;
+    ex.vscp_type  = 13;
+    p1.eventExToReceiveQueue(ex);
+    drainReceiveQueue(p1);
+  }
+
+  uint64_t ns = nsNow() - start;
+  printf("event + queue:   %10.1f ns/event\n", (double) ns / cnt);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// benchPipeline
+//
+// The worker thread path: framer, telegram framing and CRC check,
+// item dispatch, events and receive queue.
+//
+
+static void
+benchPipeline(CEnergyP1 &p1, const std::string &data, int passes)
+{
+  uint64_t cntTelegrams = 0;
+  uint64_t cntEvents    = 0;
+  uint64_t cntCrcErrors = p1.m_telegram.getCrcErrorCount();
+  uint64_t cntAlloc     = g_cntAlloc;
+  uint64_t start        = nsNow();
+
+  for (int i = 0; i < passes; i++) {
+    size_t pos = 0;
+    while (pos < data.length()) {
+      size_t len = data.length() - pos;
+      if (len > BENCH_CHUNK_SIZE) {
+        len = BENCH_CHUNK_SIZE;
+      }
+      pos += p1.m_framer.write(data.data() + pos, len);
+
+      const char *pline;
+      size_t linelen;
+      while (p1.m_framer.getLine(&pline, &linelen)) {
+        if (P1_TELEGRAM_COMPLETE == p1.m_telegram.addLine(pline, linelen)) {
+          p1.doTelegram(p1.m_telegram);
+          cntEvents += drainReceiveQueue(p1);
+          cntTelegrams++;
+        }
+      }
+    }
+  }
+
+  uint64_t ns = nsNow() - start;
+  cntAlloc    = g_cntAlloc - cntAlloc;
+
+  if (!cntTelegrams) {
+    printf("pipeline:        no complete telegrams in input (%llu CRC errors)\n",
+           (unsigned long long) (p1.m_telegram.getCrcErrorCount() - cntCrcErrors));
+    return;
+  }
+
+  printf("pipeline:        %10.1f ns/telegram  (%llu telegrams, %llu CRC errors)\n",
+         (double) ns / cntTelegrams,
+         (unsigned long long) cntTelegrams,
+         (unsigned long long) (p1.m_telegram.getCrcErrorCount() - cntCrcErrors));
+  printf("                 %10.1f allocs/telegram\n", (double) cntAlloc / cntTelegrams);
+  printf("                 %10.0f events/s\n", (double) cntEvents * 1e9 / ns);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// main
+//
+
+int
+main(int argc, char **argv)
+{
+  int passes = BENCH_DEFAULT_PASSES;
+  std::vector<std::string> files;
+
+  if (argc > 1) {
+    passes = atoi(argv[1]);
+    if (passes <= 0) {
+      fprintf(stderr, "Usage: bench [passes] [file ...]\n");
+      return -1;
+    }
+  }
+
+  for (int i = 2; i < argc; i++) {
+    files.push_back(argv[i]);
+  }
+
+  if (!files.size()) {
+    files.push_back("../python/hanp1_1.data");
+    files.push_back("../python/hanp1_2.data");
+    files.push_back("../python/minicom.cap");
+  }
+
+  spdlog::set_level(spdlog::level::warn);
+
+  std::string data;
+  for (auto const &path : files) {
+    if (!loadFile(path, data)) {
+      return -1;
+    }
+  }
+
+  // Data lines (not header, empty or CRC lines) for the line benchmarks
+  std::vector<std::string> lines;
+  std::istringstream in(data);
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.length() && ('/' != line[0]) && ('!' != line[0]) && ('\r' != line[0])) {
+      lines.push_back(line + '\n');
+    }
+  }
+
+  CEnergyP1 p1;
+  p1.loadBuiltinItems();
+  p1.buildItemIndex();
+
+  printf("%zu bytes, %zu data lines, %d passes, %zu items\n\n",
+         data.length(),
+         lines.size(),
+         passes,
+         p1.m_listItems.size());
+
+  benchLines(p1, lines, passes);
+  benchUnit(p1, lines, passes);
+  benchEvent(p1, passes);
+  benchPipeline(p1, data, passes);
+
+  return 0;
+}
@@ -19,7 +19,6 @@
 // along with this file see the file COPYING.  If not, write to
 // the Free Software Foundation, 59 Temple Place - Suite 330,
 // Boston, MA 02111-1307, USA.
-//
 
 #if !defined(VSCPENERGYP1_TEST_H__202105112227__INCLUDED_)
 #define VSCPENERGYP1_TEST_H__202105112227__INCLUDED_
@@ -33,10 +32,13 @@
 #include <map>
 #include <string>
 
+#include <math.h>
 #include <pthread.h>
+#include <sched.h>
 #include <semaphore.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #if WIN32
 #else
@@ -50,6 +52,7 @@
 #include <dllist.h>
 #include <guid.h>
 #include <vscp.h>
+#include <vscp_class.h>
 
 #include <nlohmann/json.hpp>  // Needs C++11  -std=c++11
 
@@ -57,16 +60,876 @@
 #include "spdlog/sinks/rotating_file_sink.h"
 
 #include "../src/alarm.h"
-#include "../src/p1item.h"
 #include "../src/energy-p1-obj.h"
+#include "../src/eventpool.h"
+#include "../src/eventqueue.h"
+#include "../src/obis.h"
+#include "../src/p1encode.h"
+#include "../src/p1item.h"
+#include "../src/p1line.h"
+#include "../src/p1telegram.h"
+#include "../src/p1time.h"
+
+// Number of failed checks
+static int gFailures = 0;
+
+#define CHECK(cond)                                                            \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      gFailures++;                                                             \
+    }                                                                          \
+  } while (0)
+
+
+// Telegram from a real meter (python/hanp1_1.data with CR put back)
+static const char *gTelegram = "/ELL5\\253833635_A\r\n"
+                               "\r\n"
+                               "0-0:1.0.0(230614220548W)\r\n"
+                               "1-0:1.8.0(00040649.246*kWh)\r\n"
+                               "1-0:2.8.0(00000000.001*kWh)\r\n"
+                               "1-0:3.8.0(00001090.590*kvarh)\r\n"
+                               "1-0:4.8.0(00003597.232*kvarh)\r\n"
+                               "1-0:1.7.0(0001.037*kW)\r\n"
+                               "1-0:2.7.0(0000.000*kW)\r\n"
+                               "1-0:3.7.0(0000.217*kvar)\r\n"
+                               "1-0:4.7.0(0000.775*kvar)\r\n"
+                               "1-0:21.7.0(0000.424*kW)\r\n"
+                               "1-0:41.7.0(0000.394*kW)\r\n"
+                               "1-0:61.7.0(0000.217*kW)\r\n"
+                               "1-0:22.7.0(0000.000*kW)\r\n"
+                               "1-0:42.7.0(0000.000*kW)\r\n"
+                               "1-0:62.7.0(0000.000*kW)\r\n"
+                               "1-0:23.7.0(0000.217*kvar)\r\n"
+                               "1-0:43.7.0(0000.000*kvar)\r\n"
+                               "1-0:63.7.0(0000.000*kvar)\r\n"
+                               "1-0:24.7.0(0000.000*kvar)\r\n"
+                               "1-0:44.7.0(0000.101*kvar)\r\n"
+                               "1-0:64.7.0(0000.673*kvar)\r\n"
+                               "1-0:32.7.0(237.5*V)\r\n"
+                               "1-0:52.7.0(237.2*V)\r\n"
+                               "1-0:72.7.0(238.9*V)\r\n"
+                               "1-0:31.7.0(002.0*A)\r\n"
+                               "1-0:51.7.0(002.0*A)\r\n"
+                               "1-0:71.7.0(003.0*A)\r\n"
+                               "!6437\r\n";
+
+// Number of OBIS codes in gTelegram
+#define TEST_TELEGRAM_OBIS_CODES 27
+
+///////////////////////////////////////////////////////////////////////////////
+// addTelegram
+//
+// Feed text line by line to a telegram, return result for last line
+//
+
+static int
+addTelegram(CP1Telegram &telegram, const std::string &text)
+{
+  int rv     = P1_TELEGRAM_NO_START;
+  size_t pos = 0;
+  while (pos < text.length()) {
+    size_t end = text.find('\n', pos);
+    end        = (std::string::npos == end) ? text.length() : end + 1;
+    rv         = telegram.addLine(text.data() + pos, end - pos);
+    pos        = end;
+  }
+  return rv;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// crc16Bitwise
+//
+// Reference CRC-16/ARC one bit at a time
+//
+
+static uint16_t
+crc16Bitwise(uint16_t crc, const uint8_t *pdata, size_t len)
+{
+  while (len--) {
+    crc ^= *pdata++;
+    for (int i = 0; i < 8; i++) {
+      crc = (crc & 1) ? ((crc >> 1) ^ 0xA001) : (crc >> 1);
+    }
+  }
+  return crc;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// testCrc16
+//
+
+static void
+testCrc16(void)
+{
+  // CRC-16/ARC check value
+  CHECK(0xBB3D == CP1Telegram::crc16(0, (const uint8_t *) "123456789", 9));
+  CHECK(0 == CP1Telegram::crc16(0, (const uint8_t *) "", 0));
+
+  // Slice-by-8 must give the same result for every length and
+  // alignment, also when the data is split in two calls
+  uint8_t buf[80];
+  for (size_t i = 0; i < sizeof(buf); i++) {
+    buf[i] = (uint8_t) (i * 37 + 11);
+  }
+  for (size_t start = 0; start < 8; start++) {
+    for (size_t len = 0; len <= sizeof(buf) - start; len++) {
+      uint16_t ref = crc16Bitwise(0, buf + start, len);
+      CHECK(ref == CP1Telegram::crc16(0, buf + start, len));
+      CHECK(ref == CP1Telegram::crc16(CP1Telegram::crc16(0, buf + start, len / 3), buf + start + len / 3, len - len / 3));
+    }
+  }
+
+  // Known good telegram
+  CP1Telegram telegram;
+  CHECK(P1_TELEGRAM_COMPLETE == addTelegram(telegram, gTelegram));
+  CHECK(telegram.hasCrc());
+  CHECK(30 == telegram.getLineCount());
+  CHECK(1 == telegram.getTelegramCount());
+
+  // One digit changed
+  std::string bad = gTelegram;
+  bad[bad.find("40649")] = '5';
+  CHECK(P1_TELEGRAM_CRC_ERROR == addTelegram(telegram, bad));
+  CHECK(1 == telegram.getCrcErrorCount());
+
+  // Wrong CRC accepted with the check disabled
+  telegram.setCrcCheck(false);
+  CHECK(P1_TELEGRAM_COMPLETE == addTelegram(telegram, bad));
+  CHECK(2 == telegram.getTelegramCount());
+
+  // Line outside of a telegram
+  CP1Telegram stray;
+  CHECK(P1_TELEGRAM_NO_START == stray.addLine("1-0:1.8.0(1*kWh)\r\n", 18));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// testObis
+//
+
+static void
+testObis(void)
+{
+  uint64_t key;
+
+  CHECK(9 == obis_parse("1-0:1.8.0(00040649.246*kWh)", 27, &key));
+  CHECK(OBIS_KEY(1, 0, 1, 8, 0, 255) == key);
+  CHECK(12 == obis_parse("0-1:24.2.1*2", 12, &key));
+  CHECK(OBIS_KEY(0, 1, 24, 2, 1, 2) == key);
+  CHECK(23 == obis_parse("255-255:255.255.255*255", 23, &key));
+  CHECK(OBIS_KEY(255, 255, 255, 255, 255, 255) == key);
+
+  // Invalid codes
+  CHECK(0 == obis_parse("1-0:1.8(", 8, &key));
+  CHECK(0 == obis_parse("1-0:256.8.0", 11, &key));
+  CHECK(0 == obis_parse("1-0:.8.0", 8, &key));
+  CHECK(0 == obis_parse("/ELL5", 5, &key));
+  CHECK(0 == obis_parse("", 0, &key));
+
+  // All codes of the telegram in the map. Items are never used by
+  // the map so any distinct pointer will do.
+  static CP1Item *items[TEST_TELEGRAM_OBIS_CODES + 1];
+  uint64_t keys[TEST_TELEGRAM_OBIS_CODES];
+  size_t cntKeys = 0;
+
+  CObisMap map;
+  const char *p = gTelegram;
+  while (nullptr != (p = strchr(p, '\n'))) {
+    p++;
+    size_t len = strcspn(p, "(\r\n");
+    if (len && obis_parse(p, len, &key)) {
+      CHECK(cntKeys < TEST_TELEGRAM_OBIS_CODES);
+      if (cntKeys < TEST_TELEGRAM_OBIS_CODES) {
+        items[cntKeys] = reinterpret_cast<CP1Item *>(&keys[cntKeys]);
+        keys[cntKeys]  = key;
+        map.add(key, items[cntKeys]);
+        cntKeys++;
+      }
+    }
+  }
+  CHECK(TEST_TELEGRAM_OBIS_CODES == cntKeys);
+
+  // Second item for 1.8.0, found after the first
+  items[TEST_TELEGRAM_OBIS_CODES] = reinterpret_cast<CP1Item *>(&cntKeys);
+  map.add(OBIS_KEY(1, 0, 1, 8, 0, 255), items[TEST_TELEGRAM_OBIS_CODES]);
+
+  map.build();
+  CHECK(TEST_TELEGRAM_OBIS_CODES == map.getKeyCount());
+  CHECK(map.isPerfect());
+
+  CP1Item *const *ppItems;
+  for (size_t i = 0; i < cntKeys; i++) {
+    size_t cnt = map.find(keys[i], &ppItems);
+    if (OBIS_KEY(1, 0, 1, 8, 0, 255) == keys[i]) {
+      CHECK(2 == cnt);
+      CHECK((2 == cnt) && (items[i] == ppItems[0]) && (items[TEST_TELEGRAM_OBIS_CODES] == ppItems[1]));
+    }
+    else {
+      CHECK((1 == cnt) && (items[i] == ppItems[0]));
+    }
+  }
+
+  // Codes not in the map
+  CHECK(0 == map.find(OBIS_KEY(1, 0, 1, 8, 1, 255), &ppItems));
+  CHECK(0 == map.find(OBIS_KEY(0, 1, 24, 2, 1, 255), &ppItems));
+  CHECK(0 == map.find(0, &ppItems));
+
+  // Empty map
+  CObisMap empty;
+  empty.build();
+  CHECK(0 == empty.find(OBIS_KEY(1, 0, 1, 8, 0, 255), &ppItems));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// testDecimal
+//
+
+static void
+testDecimal(void)
+{
+  double value;
+
+  CHECK(p1_parse_decimal("00040649.246", 12, &value) && (40649.246 == value));
+  CHECK(p1_parse_decimal("-0012.345", 9, &value) && (-12.345 == value));
+  CHECK(p1_parse_decimal("+7", 2, &value) && (7 == value));
+  CHECK(p1_parse_decimal("0000.000", 8, &value) && (0 == value));
+  CHECK(p1_parse_decimal("237.5", 5, &value) && (237.5 == value));
+  CHECK(p1_parse_decimal("0.1", 3, &value) && (0.1 == value));
+  // Digits past 19 only scale the value
+  CHECK(p1_parse_decimal("12345678901234567890123", 23, &value) && (fabs(value / 1.2345678901234568e22 - 1) < 1e-15));
+
+  // Never a locale decimal point
+  CHECK(!p1_parse_decimal("1,5", 3, &value));
+  CHECK(!p1_parse_decimal("", 0, &value));
+  CHECK(!p1_parse_decimal("-", 1, &value));
+  CHECK(!p1_parse_decimal(".", 1, &value));
+  CHECK(!p1_parse_decimal("1.2.3", 5, &value));
+  CHECK(!p1_parse_decimal("12*kWh", 6, &value));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// testFixedPoint
+//
+
+static void
+testFixedPoint(void)
+{
+  p1_fixed fixed;
+  char buf[32];
+
+  CHECK(p1_parse_fixed("00040649.246", 12, &fixed));
+  CHECK((40649246 == fixed.mantissa) && (-3 == fixed.exp));
+  CHECK(p1_parse_fixed("-0012.345", 9, &fixed));
+  CHECK((-12345 == fixed.mantissa) && (-3 == fixed.exp));
+  CHECK(p1_parse_fixed("00000000.001", 12, &fixed));
+  CHECK((1 == fixed.mantissa) && (-3 == fixed.exp));
+  CHECK(p1_parse_fixed("123456789012345678", 18, &fixed));
+  CHECK((123456789012345678LL == fixed.mantissa) && (0 == fixed.exp));
+  CHECK(!p1_parse_fixed("1234567890123456789", 19, &fixed)); // 19 digits
+  CHECK(!p1_parse_fixed("1,5", 3, &fixed));
+  CHECK(!p1_parse_fixed("", 0, &fixed));
+
+  p1_fixed f1 = { 40649246, -3 };
+  CHECK((9 == p1_format_fixed(buf, sizeof(buf), f1)) && (0 == strcmp(buf, "40649.246")));
+  p1_fixed f2 = { 1, -3 };
+  CHECK((5 == p1_format_fixed(buf, sizeof(buf), f2)) && (0 == strcmp(buf, "0.001")));
+  p1_fixed f3 = { -12345, -3 };
+  CHECK((7 == p1_format_fixed(buf, sizeof(buf), f3)) && (0 == strcmp(buf, "-12.345")));
+  p1_fixed f4 = { 15, 2 };
+  CHECK((4 == p1_format_fixed(buf, sizeof(buf), f4)) && (0 == strcmp(buf, "1500")));
+  p1_fixed f5 = { 0, -3 };
+  CHECK((5 == p1_format_fixed(buf, sizeof(buf), f5)) && (0 == strcmp(buf, "0.000")));
+  CHECK(0 == p1_format_fixed(buf, 5, f1)); // Buffer too small
+
+  // Exact conversion and rounding
+  CHECK(40649.246 == p1_fixed_to_double(f1));
+  p1_fixed f6 = { 12345, -3 };
+  p1_fixed_drop_digit(&f6);
+  CHECK((1235 == f6.mantissa) && (-2 == f6.exp));
+  p1_fixed f7 = { -12345, -3 };
+  p1_fixed_drop_digit(&f7);
+  CHECK((-1235 == f7.mantissa) && (-2 == f7.exp));
+
+  // Factor applied without going through floating point
+  CP1Line line;
+  const char *ptext = "1-0:1.8.0(00040649.246*kWh)\r\n";
+  CHECK(line.parse(ptext, strlen(ptext)));
+
+  CP1Item item;
+  item.setFactor(1000);
+  CHECK(item.getFixedValue(line, &fixed) && (40649246 == fixed.mantissa) && (0 == fixed.exp));
+  item.setFactor(0.001);
+  CHECK(item.getFixedValue(line, &fixed) && (40649246 == fixed.mantissa) && (-6 == fixed.exp));
+  item.setFactor(1);
+  CHECK(item.getFixedValue(line, &fixed) && (40649246 == fixed.mantissa) && (-3 == fixed.exp));
+
+  // Not a decimal factor, rounded to the decimals from the meter
+  item.setFactor(1.0 / 3);
+  CHECK(item.getFixedValue(line, &fixed) && (13549749 == fixed.mantissa) && (-3 == fixed.exp));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// testTimestamp
+//
+
+static void
+testTimestamp(void)
+{
+  int64_t t;
+  p1_datetime dt;
+
+  CHECK(0 == p1_days_from_civil(1970, 1, 1));
+  CHECK(11016 == p1_days_from_civil(2000, 2, 29));
+  CHECK(-1 == p1_days_from_civil(1969, 12, 31));
+
+  p1_datetime_from_epoch(11016LL * 86400 + 3723, &dt);
+  CHECK((2000 == dt.year) && (2 == dt.month) && (29 == dt.day));
+  CHECK((1 == dt.hour) && (2 == dt.minute) && (3 == dt.second));
+  p1_datetime_from_epoch(1735689599, &dt);
+  CHECK((2024 == dt.year) && (12 == dt.month) && (31 == dt.day));
+  CHECK((23 == dt.hour) && (59 == dt.minute) && (59 == dt.second));
+
+  // Timestamp from the telegram, CET
+  CHECK(p1_parse_timestamp("230614220548W", 13, 60, &t) && (1686776748 == t));
+  CHECK(p1_parse_timestamp("230614220548S", 13, 60, &t) && (1686773148 == t));
+  CHECK(p1_parse_timestamp("230614220548", 12, 60, &t) && (1686776748 == t));
+  CHECK(p1_parse_timestamp("230614220548W", 13, 0, &t) && (1686780348 == t));
+
+  // Invalid timestamps
+  CHECK(!p1_parse_timestamp("231314220548W", 13, 60, &t)); // Month 13
+  CHECK(!p1_parse_timestamp("230600220548W", 13, 60, &t)); // Day 0
+  CHECK(!p1_parse_timestamp("230614240548W", 13, 60, &t)); // Hour 24
+  CHECK(!p1_parse_timestamp("230614220548X", 13, 60, &t));
+  CHECK(!p1_parse_timestamp("2306142205W", 11, 60, &t));
+  CHECK(!p1_parse_timestamp("23061422054aW", 13, 60, &t));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// encode
+//
+// Encode a value with the encoder for a class/coding
+//
+
+static bool
+encode(vscpEventEx &ex, uint16_t vscp_class, uint8_t coding, bool bFixedPoint, const char *pvalue, uint16_t pos)
+{
+  p1_value val;
+  bool bFixed;
+
+  memset(&ex, 0, sizeof(ex));
+  if (!p1_parse_decimal(pvalue, strlen(pvalue), &val.value) ||
+      !p1_parse_fixed(pvalue, strlen(pvalue), &val.fixed)) {
+    return false;
+  }
+
+  p1_encoder encoder = p1_get_encoder(vscp_class, coding, bFixedPoint, &bFixed);
+  return (nullptr != encoder) && encoder(&ex, pos, val, 1, 2);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// testEncoders
+//
+
+static void
+testEncoders(void)
+{
+  vscpEventEx ex;
+  bool bFixed;
+
+  // Normalized integer: exponent -3 and mantissa 40649246 (0x026C421E)
+  CHECK(encode(ex, VSCP_CLASS1_MEASUREMENT, VSCP_DATACODING_NORMALIZED, false, "00040649.246", 0));
+  const uint8_t norm[] = { VSCP_DATACODING_NORMALIZED | (1 << 3) | 2, 0x83, 0x02, 0x6C, 0x42, 0x1E };
+  CHECK((sizeof(norm) == ex.sizeData) && (0 == memcmp(ex.data, norm, sizeof(norm))));
+
+  // Integer: 40649 (0x9EC9) needs a zero byte in front to stay positive
+  CHECK(encode(ex, VSCP_CLASS1_MEASUREMENT, VSCP_DATACODING_INTEGER, false, "00040649.246", 0));
+  const uint8_t integer[] = { VSCP_DATACODING_INTEGER | (1 << 3) | 2, 0x00, 0x9E, 0xC9 };
+  CHECK((sizeof(integer) == ex.sizeData) && (0 == memcmp(ex.data, integer, sizeof(integer))));
+
+  CHECK(encode(ex, VSCP_CLASS1_MEASUREMENT, VSCP_DATACODING_INTEGER, false, "-1", 0));
+  CHECK((2 == ex.sizeData) && (0xFF == ex.data[1]));
+
+  // String: decimals that do not fit in seven bytes are dropped
+  CHECK(encode(ex, VSCP_CLASS1_MEASUREMENT, VSCP_DATACODING_STRING, false, "00040649.246", 0));
+  CHECK((8 == ex.sizeData) && (0 == memcmp(ex.data + 1, "40649.2", 7)));
+  CHECK(encode(ex, VSCP_CLASS1_MEASUREMENT, VSCP_DATACODING_STRING, false, "237.5", 0));
+  CHECK((6 == ex.sizeData) && (0 == memcmp(ex.data + 1, "237.5", 5)));
+  CHECK(!encode(ex, VSCP_CLASS1_MEASUREMENT, VSCP_DATACODING_STRING, false, "123456789", 0));
+
+  // Single precision float, MSB first
+  CHECK(encode(ex, VSCP_CLASS1_MEASUREMENT, VSCP_DATACODING_SINGLE, false, "237.5", 0));
+  const uint8_t single[] = { VSCP_DATACODING_SINGLE | (1 << 3) | 2, 0x43, 0x6D, 0x80, 0x00 };
+  CHECK((sizeof(single) == ex.sizeData) && (0 == memcmp(ex.data, single, sizeof(single))));
+
+  // Zone class, value after sensor index, zone and subzone
+  CHECK(encode(ex, VSCP_CLASS1_MEASUREZONE, VSCP_DATACODING_INTEGER, false, "5", 3));
+  CHECK((5 == ex.sizeData) && (0x05 == ex.data[4]));
+  // Zone class has three mantissa bytes, 40649.246 is rounded to 4064925 (0x3E069D) with exponent -2
+  CHECK(encode(ex, VSCP_CLASS1_MEASUREZONE, VSCP_DATACODING_NORMALIZED, false, "00040649.246", 3));
+  const uint8_t zone[] = { VSCP_DATACODING_NORMALIZED | (1 << 3) | 2, 0x82, 0x3E, 0x06, 0x9D };
+  CHECK((8 == ex.sizeData) && (0 == memcmp(ex.data + 3, zone, sizeof(zone))));
+  CHECK(encode(ex, VSCP_CLASS1_MEASUREZONE, VSCP_DATACODING_STRING, false, "237.5", 3));
+  CHECK((7 == ex.sizeData) && (0 == memcmp(ex.data + 4, "237", 3)));
+  CHECK(!encode(ex, VSCP_CLASS1_MEASUREZONE, VSCP_DATACODING_STRING, false, "00040649.246", 3));
+
+  // 64 bit double, MSB first
+  CHECK(encode(ex, VSCP_CLASS1_MEASUREMENT64, 0, false, "237.5", 0));
+  const uint8_t dbl[] = { 0x40, 0x6D, 0xB0, 0x00, 0x00, 0x00, 0x00, 0x00 };
+  CHECK((sizeof(dbl) == ex.sizeData) && (0 == memcmp(ex.data, dbl, sizeof(dbl))));
+
+  // Level II string, '.' as decimal point whatever the locale
+  CHECK(encode(ex, VSCP_CLASS2_MEASUREMENT_STR, 0, false, "00040649.246", 4));
+  CHECK((16 == ex.sizeData) && (1 == ex.data[3]) && (0 == memcmp(ex.data + 4, "40649.246000", 12)));
+  CHECK(encode(ex, VSCP_CLASS2_MEASUREMENT_STR, 0, false, "-0012.345", 4));
+  CHECK((14 == ex.sizeData) && (0 == memcmp(ex.data + 4, "-12.345000", 10)));
+
+  // Level II string with the digits from the meter
+  CHECK(encode(ex, VSCP_CLASS2_MEASUREMENT_STR, 0, true, "00040649.246", 4));
+  CHECK((13 == ex.sizeData) && (0 == memcmp(ex.data + 4, "40649.246", 9)));
 
-int main()
-{ 
+  // Not supported
+  CHECK(nullptr == p1_get_encoder(VSCP_CLASS1_MEASUREMENT, 0xE0, false, &bFixed));
+  CHECK(nullptr == p1_get_encoder(VSCP_CLASS1_PROTOCOL, 0, false, &bFixed));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// testTelegramEvents
+//
+// Whole telegram through doTelegram with the built in items
+//
+
+static void
+testTelegramEvents(void)
+{
   CEnergyP1 p1;
-  
-  
+  CHECK(p1.loadBuiltinItems());
+  p1.buildItemIndex();
+
+  CHECK(P1_TELEGRAM_COMPLETE == addTelegram(p1.m_telegram, gTelegram));
+  CHECK(p1.doTelegram(p1.m_telegram));
+
+  // One CLASS2.MEASUREMENT_STR per item line, in telegram order. Data
+  // is sensor index, zone, subzone, unit and the value as a string.
+  vscpEvent *pev;
+  double value;
+  int cnt = 0;
+  while (nullptr != (pev = p1.popReceiveQueue())) {
+    CHECK(VSCP_CLASS2_MEASUREMENT_STR == pev->vscp_class);
+    CHECK(pev->sizeData > 4);
+    if (pev->sizeData > 4) {
+      CHECK(p1_parse_decimal((const char *) pev->pdata + 4, pev->sizeData - 4, &value));
+      switch (cnt) {
+        case 0: // 1-0:1.8.0 energy out, kWh
+          CHECK((13 == pev->vscp_type) && (0 == pev->pdata[0]) && (1 == pev->pdata[3]));
+          CHECK(40649.246 == value);
+          break;
+        case 1: // 1-0:2.8.0 energy in, kWh
+          CHECK((13 == pev->vscp_type) && (1 == pev->pdata[0]));
+          CHECK(0.001 == value);
+          break;
+        case 4: // 1-0:1.7.0 power out, kW sent as W
+          CHECK((14 == pev->vscp_type) && (4 == pev->pdata[0]));
+          CHECK(1037 == value);
+          break;
+        case 25: // 1-0:71.7.0 current L3
+          CHECK((5 == pev->vscp_type) && (25 == pev->pdata[0]));
+          CHECK(3 == value);
+          break;
+      }
+    }
+    p1.m_eventPool.release(pev);
+    cnt++;
+  }
+
+  // All lines but the header, the empty line, the time and the CRC
+  CHECK(26 == cnt);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// testEventQueue
+//
+
+static void
+testEventQueue(void)
+{
+  vscpEvent ev[10];
+  vscpEvent *ppev[10];
+  for (int i = 0; i < 10; i++) {
+    ppev[i] = &ev[i];
+  }
+
+  CEventQueue queue(8);
+  CHECK(queue.isEmpty());
+  CHECK(nullptr == queue.pop());
+
+  for (int i = 0; i < 8; i++) {
+    CHECK(queue.push(&ev[i]));
+  }
+  CHECK(!queue.push(&ev[8]));
+  CHECK(8 == queue.size());
+
+  // FIFO order, many times around the ring
+  for (int n = 0; n < 1000; n++) {
+    CHECK(&ev[n % 8] == queue.pop());
+    CHECK(queue.push(&ev[n % 8]));
+  }
+  for (int i = 0; i < 8; i++) {
+    CHECK(&ev[i] == queue.pop());
+  }
+  CHECK(queue.isEmpty());
+
+  // Bulk push stops when the queue is full
+  CHECK(8 == queue.push(ppev, 10));
+  CHECK(&ev[0] == queue.pop());
+  CHECK(1 == queue.push(ppev + 8, 2));
+  for (int i = 1; i < 9; i++) {
+    CHECK(&ev[i] == queue.pop());
+  }
+  CHECK(queue.isEmpty());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// testEventQueueLimit
+//
+
+static void
+testEventQueueLimit(void)
+{
+  vscpEvent ev[8];
+  vscpEvent *ppev[8];
+  for (int i = 0; i < 8; i++) {
+    ppev[i] = &ev[i];
+  }
+
+  CEventQueue queue(5);
+  CHECK(5 == queue.getLimit());
+
+  for (int i = 0; i < 5; i++) {
+    CHECK(queue.push(&ev[i]));
+  }
+  CHECK(!queue.push(&ev[5]));
+  CHECK(5 == queue.size());
+
+  // Bulk push stops at the limit
+  CHECK(&ev[0] == queue.pop());
+  CHECK(1 == queue.push(ppev + 5, 3));
+  for (int i = 1; i < 6; i++) {
+    CHECK(&ev[i] == queue.pop());
+  }
+  CHECK(queue.isEmpty());
+
+  // Limit clamped to the ring, events over a lowered limit are kept
+  queue.setLimit(0);
+  CHECK(1 == queue.getLimit());
+  queue.setLimit(100000);
+  CHECK(8 == queue.getLimit());
+  CHECK(8 == queue.push(ppev, 8));
+  queue.setLimit(2);
+  CHECK(8 == queue.size());
+  CHECK(!queue.push(&ev[0]));
+  for (int i = 0; i < 8; i++) {
+    CHECK(&ev[i] == queue.pop());
+  }
+  CHECK(nullptr == queue.pop());
+}
+
+// Events per producer in the multi producer test
+#define TEST_MP_COUNT 20000
+
+static vscpEvent gMPEvents[2][TEST_MP_COUNT];
+
+struct mpProducer {
+  CEventQueueMP *pqueue;
+  vscpEvent *pev;
+};
+
+static void *
+mpProducerThread(void *p)
+{
+  mpProducer *pprod = (mpProducer *) p;
+  for (int i = 0; i < TEST_MP_COUNT; i++) {
+    while (!pprod->pqueue->push(&pprod->pev[i])) {
+      sched_yield();
+    }
+  }
+  return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// testEventQueueMP
+//
+
+static void
+testEventQueueMP(void)
+{
+  vscpEvent ev[8];
+
+  CEventQueueMP queue(6);
+  CHECK(8 == queue.getSize());
+  CHECK(nullptr == queue.pop());
+
+  for (int i = 0; i < 8; i++) {
+    CHECK(queue.push(&ev[i]));
+  }
+  CHECK(!queue.push(&ev[0]));
+  for (int n = 0; n < 100; n++) {
+    CHECK(&ev[n % 8] == queue.pop());
+    CHECK(queue.push(&ev[n % 8]));
+  }
+  for (int i = 4; i < 12; i++) {
+    CHECK(&ev[i % 8] == queue.pop());
+  }
+  CHECK(nullptr == queue.pop());
+
+  // Two producers, each one's events must come out complete and in order
+  CEventQueueMP mpqueue(64);
+  mpProducer prod[2] = { { &mpqueue, gMPEvents[0] }, { &mpqueue, gMPEvents[1] } };
+  pthread_t threads[2];
+  for (int i = 0; i < 2; i++) {
+    pthread_create(&threads[i], NULL, mpProducerThread, &prod[i]);
+  }
+
+  int next[2] = { 0, 0 };
+  int cnt     = 0;
+  bool bOrder = true;
+  while (cnt < (2 * TEST_MP_COUNT)) {
+    vscpEvent *pev = mpqueue.pop();
+    if (nullptr == pev) {
+      sched_yield();
+      continue;
+    }
+    int producer = (pev >= gMPEvents[1]) ? 1 : 0;
+    if (pev != &gMPEvents[producer][next[producer]]) {
+      bOrder = false;
+    }
+    next[producer]++;
+    cnt++;
+  }
+
+  for (int i = 0; i < 2; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  CHECK(bOrder);
+  CHECK((TEST_MP_COUNT == next[0]) && (TEST_MP_COUNT == next[1]));
+  CHECK(nullptr == mpqueue.pop());
+}
+
+// Events in the pool test
+#define TEST_POOL_COUNT 20000
+
+struct poolReader {
+  CEventQueue *pqueue;
+  CEventPool *ppool;
+  bool bOrder;
+};
+
+static void *
+poolReaderThread(void *p)
+{
+  poolReader *preader = (poolReader *) p;
+  for (uint32_t i = 0; i < TEST_POOL_COUNT; i++) {
+    vscpEvent *pev;
+    while (nullptr == (pev = preader->pqueue->pop())) {
+      sched_yield();
+    }
+    if (i != pev->timestamp) {
+      preader->bOrder = false;
+    }
+    preader->ppool->releaseReader(pev);
+  }
+  return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// testEventPool
+//
+
+static void
+testEventPool(void)
+{
+  CEventPool pool(4, 2);
+  vscpEvent *ppev[4];
+
+  // Worker slots are reused
+  ppev[0] = pool.alloc();
+  CHECK((nullptr != ppev[0]) && (4 == pool.getSlotCount()));
+  pool.release(ppev[0]);
+  CHECK(ppev[0] == pool.alloc());
+
+  // Given back by the reader, two through the ring and two through
+  // the locked list, and taken by the worker without growing
+  for (int i = 1; i < 4; i++) {
+    ppev[i] = pool.alloc();
+  }
+  for (int i = 0; i < 4; i++) {
+    pool.releaseReader(ppev[i]);
+  }
+  for (int i = 0; i < 4; i++) {
+    ppev[i] = pool.alloc();
+    CHECK(nullptr != ppev[i]);
+  }
+  CHECK(4 == pool.getSlotCount());
+
+  // Other threads get their own slots
+  vscpEventEx ex;
+  memset(&ex, 0, sizeof(ex));
+  ex.vscp_class = VSCP_CLASS2_HLO;
+  ex.sizeData   = 3;
+  ex.data[2]    = 0x55;
+  vscpEvent *pev = pool.fromExLocked(ex);
+  CHECK((nullptr != pev) && (8 == pool.getSlotCount()));
+  CHECK((VSCP_CLASS2_HLO == pev->vscp_class) && (3 == pev->sizeData) && (0x55 == pev->pdata[2]));
+  pool.releaseLocked(pev);
+  CHECK(pev == pool.fromExLocked(ex));
+  pool.releaseLocked(pev);
+
+  // Worker and reader threads, slots go round without the pool
+  // growing past what the queue can hold
+  CEventPool rpool(16, 32);
+  CEventQueue queue(64);
+  poolReader reader = { &queue, &rpool, true };
+  pthread_t thread;
+  pthread_create(&thread, NULL, poolReaderThread, &reader);
+
+  for (uint32_t i = 0; i < TEST_POOL_COUNT; i++) {
+    vscpEvent *pev = rpool.alloc();
+    if (nullptr == pev) {
+      break;
+    }
+    pev->timestamp = i;
+    while (!queue.push(pev)) {
+      sched_yield();
+    }
+  }
+
+  pthread_join(thread, NULL);
+
+  CHECK(reader.bOrder);
+  CHECK(rpool.getSlotCount() <= (64 + 2 * 16));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// readVar
+//
+// Do a readvar for name and return the reply
+//
+
+static json
+readVar(CEnergyP1 &p1, const std::string &name)
+{
+  vscpEventEx ex;
+  memset(&ex, 0, sizeof(ex));
+
+  json req;
+  req["op"]   = "readvar";
+  req["name"] = name;
+  p1.readVariable(ex, req);
+
+  CHECK(ex.sizeData <= VSCP_MAX_DATA);
+  return json::parse(std::string((const char *) ex.data, ex.sizeData));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// testReadVariable
+//
+
+static void
+testReadVariable(void)
+{
+  CEnergyP1 p1;
+
+  // Three lines through the framer
+  const char *pdata = "/ISK5\\2M550T-1012\r\n\r\n1-0:1.8.1(000001.000*kWh)\r\n";
+  const char *pline;
+  size_t len;
+  p1.m_framer.write(pdata, strlen(pdata));
+  while (p1.m_framer.getLine(&pline, &len))
+    ;
+
+  json j = readVar(p1, "stat-lines");
+  CHECK(VSCP_ERROR_SUCCESS == j.value("result", -1));
+  CHECK("stat-lines" == j["arg"].value("name", ""));
+  CHECK(3 == j["arg"].value("value", 0));
+
+  j = readVar(p1, "stat-queue-dropped");
+  CHECK(VSCP_ERROR_SUCCESS == j.value("result", -1));
+  CHECK(0 == j["arg"].value("value", -1));
+
+  j = readVar(p1, "no-such-variable");
+  CHECK(VSCP_ERROR_SUCCESS != j.value("result", VSCP_ERROR_SUCCESS));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// testAlarm
+//
+
+static void
+testAlarm(void)
+{
+  // One-shot: sent when the condition becomes true, again only after
+  // it has been false
+  CAlarm oneshot("power", alarm_op::gt, 10, 0, 0, 0, true);
+  CHECK(!oneshot.check(5));
+  CHECK(oneshot.check(11));
+  CHECK(!oneshot.check(12));
+  CHECK(!oneshot.check(10.5));
+  CHECK(!oneshot.check(10)); // Not above, armed again
+  CHECK(oneshot.check(11));
+
+  // Not one-shot: sent every time the condition is true
+  CAlarm always("power", alarm_op::le, 10, 0, 0, 0, false);
+  CHECK(always.check(10));
+  CHECK(always.check(9));
+  CHECK(!always.check(11));
+  CHECK(always.check(-1));
+
+  CAlarm ge("voltage", alarm_op::ge, 253, 0, 0, 0, true);
+  CHECK(!ge.check(252.9));
+  CHECK(ge.check(253));
+  CHECK(!ge.check(254));
+
+  CAlarm eq("tariff", alarm_op::eq, 2, 0, 0, 0, true);
+  CHECK(!eq.check(1));
+  CHECK(eq.check(2));
+  CHECK(!eq.check(2));
+
+  CAlarm ne("tariff", alarm_op::ne, 2, 0, 0, 0, true);
+  CHECK(ne.check(1));
+  CHECK(!ne.check(1));
+  CHECK(!ne.check(2));
+  CHECK(ne.check(1));
+
+  CAlarm lt("current", alarm_op::lt, 0, 0, 0, 0, true);
+  CHECK(lt.check(-0.1));
+  CHECK(!lt.check(0));
+}
+
+int
+main()
+{
+  testCrc16();
+  testObis();
+  testDecimal();
+  testFixedPoint();
+  testTimestamp();
+  testEncoders();
+  testTelegramEvents();
+  testEventQueue();
+  testEventQueueLimit();
+  testEventQueueMP();
+  testEventPool();
+  testReadVariable();
+  testAlarm();
+
+  if (gFailures) {
+    fprintf(stderr, "%d check(s) failed\n", gFailures);
+    return 1;
+  }
+
+  printf("All checks passed\n");
   return 0;
 }
 
 
-#endif  // VSCPENERGYP1_TEST_H__202105112227__INCLUDED_
\ No newline at end of file
+#endif  // VSCPENERGYP1_TEST_H__202105112227__INCLUDED_